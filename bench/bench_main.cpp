@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/image_writer.hpp"
+#include "CrossPlatformMdlExporter/math.hpp"
+#include "CrossPlatformMdlExporter/mdl_model.hpp"
+#include "CrossPlatformMdlExporter/png_encoder.hpp"
+#include "CrossPlatformMdlExporter/qoi_encoder.hpp"
+#include "CrossPlatformMdlExporter/rasterizer.hpp"
+#include "synthetic_mdl.hpp"
+
+namespace
+{
+struct BenchmarkResult
+{
+    std::string name;
+    size_t iterations{};
+    double medianMs{};
+    double minMs{};
+    uint64_t bytes{};
+    uint64_t outputBytes{};
+};
+
+struct BenchmarkRunner
+{
+    double minSeconds{0.5};
+    size_t minIterations{3};
+    std::string filter;
+    std::vector<BenchmarkResult> results;
+    // Encoder benchmarks store the size they produced here; reported next to the timing.
+    uint64_t outputBytes{};
+
+    // Runs fn once to warm up, then repeatedly until both minIterations and minSeconds
+    // are reached. `bytes` is what one iteration reads or writes, for throughput.
+    void Run(const std::string& name, uint64_t bytes, const std::function<bool()>& fn)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+            return;
+
+        outputBytes = 0;
+        if (!fn())
+        {
+            std::cerr << name << ": FAILED\n";
+            failed = true;
+            return;
+        }
+
+        std::vector<double> samples;
+        const auto start = std::chrono::steady_clock::now();
+        while (samples.size() < minIterations || std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < minSeconds)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        BenchmarkResult r{};
+        r.name = name;
+        r.iterations = samples.size();
+        r.medianMs = samples[samples.size() / 2];
+        r.minMs = samples.front();
+        r.bytes = bytes;
+        r.outputBytes = outputBytes;
+        results.push_back(r);
+
+        char line[192]{};
+        const double mbps = r.bytes > 0 && r.medianMs > 0.0 ? static_cast<double>(r.bytes) / (r.medianMs * 1000.0) : 0.0;
+        std::snprintf(line, sizeof(line), "%-44s %8zu %12.3f %12.3f %10.1f %12llu\n", r.name.c_str(), r.iterations, r.medianMs, r.minMs, mbps, static_cast<unsigned long long>(r.outputBytes));
+        std::cout << line << std::flush;
+    }
+
+    bool failed{};
+};
+
+struct CorpusEntry
+{
+    std::string name;
+    SyntheticMdlOptions options;
+};
+
+std::vector<CorpusEntry> MakeCorpus()
+{
+    std::vector<CorpusEntry> corpus;
+
+    CorpusEntry small{"small", {}};
+    corpus.push_back(small);
+
+    CorpusEntry split{"split_masked", {}};
+    split.options.maskedTextures = true;
+    split.options.separateTextureFile = true;
+    corpus.push_back(split);
+
+    CorpusEntry medium{"medium", {}};
+    medium.options.bones = 16;
+    medium.options.bodyParts = 2;
+    medium.options.subModels = 2;
+    medium.options.meshesPerModel = 4;
+    medium.options.rings = 32;
+    medium.options.segments = 48;
+    medium.options.fanRatio = 0.5f;
+    medium.options.textures = 4;
+    medium.options.textureWidth = 256;
+    medium.options.textureHeight = 256;
+    corpus.push_back(medium);
+
+    CorpusEntry large{"large", {}};
+    large.options.bones = 32;
+    large.options.bodyParts = 4;
+    large.options.meshesPerModel = 8;
+    large.options.rings = 64;
+    large.options.segments = 96;
+    large.options.textures = 8;
+    large.options.textureWidth = 512;
+    large.options.textureHeight = 512;
+    corpus.push_back(large);
+
+    return corpus;
+}
+
+bool TryParseDouble(const std::string& s, double& out)
+{
+    try
+    {
+        size_t pos = 0;
+        const double v = std::stod(s, &pos);
+        if (pos != s.size())
+            return false;
+        out = v;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+void WriteResultsJson(const std::filesystem::path& filePath, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream out(filePath);
+    out << "{\"benchmarks\":[";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto& r = results[i];
+        if (i > 0)
+            out << ",";
+        out << "{\"name\":\"" << r.name << "\",\"iterations\":" << r.iterations << ",\"median_ms\":" << r.medianMs << ",\"min_ms\":" << r.minMs
+            << ",\"bytes\":" << r.bytes << ",\"output_bytes\":" << r.outputBytes << "}";
+    }
+    out << "]}\n";
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner;
+    std::filesystem::path jsonPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--quick")
+        {
+            runner.minSeconds = 0.0;
+            runner.minIterations = 1;
+            continue;
+        }
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            runner.filter = argv[++i];
+            continue;
+        }
+        if (arg == "--min-time" && i + 1 < argc)
+        {
+            if (!TryParseDouble(argv[++i], runner.minSeconds))
+                runner.minSeconds = 0.5;
+            continue;
+        }
+        if (arg == "--json" && i + 1 < argc)
+        {
+            jsonPath = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        std::cerr << "Usage: CrossPlatformMdlExporterBench [--quick] [--filter SUBSTRING] [--min-time SECONDS] [--json FILE]\n";
+        return 2;
+    }
+
+    std::error_code ec;
+    const auto workDir = std::filesystem::temp_directory_path(ec) / ("cpme_bench_" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directories(workDir, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot create work directory: " << workDir.string() << "\n";
+        return 1;
+    }
+
+    const auto corpus = MakeCorpus();
+    for (const auto& entry : corpus)
+    {
+        if (!WriteSyntheticMdl(workDir / (entry.name + ".mdl"), entry.options))
+        {
+            std::cerr << "Generating " << entry.name << " failed\n";
+            std::filesystem::remove_all(workDir, ec);
+            return 1;
+        }
+    }
+
+    std::printf("%-44s %8s %12s %12s %10s %12s\n", "benchmark", "iters", "median ms", "min ms", "MB/s", "out bytes");
+
+    for (const auto& entry : corpus)
+    {
+        const auto path = workDir / (entry.name + ".mdl");
+        const auto bytes = static_cast<uint64_t>(std::filesystem::file_size(path, ec));
+        runner.Run("LoadFromFile/" + entry.name, bytes, [&]() {
+            StudioModelCpu model;
+            return model.LoadFromFile(path);
+        });
+        LoadOptions geometryOnly{};
+        geometryOnly.skipTextures = true;
+        runner.Run("LoadFromFile/" + entry.name + "/skip-textures", bytes, [&]() {
+            StudioModelCpu model;
+            return model.LoadFromFile(path, geometryOnly);
+        });
+    }
+
+    StudioModelCpu medium;
+    if (!medium.LoadFromFile(workDir / "medium.mdl"))
+    {
+        std::cerr << "Loading medium.mdl failed\n";
+        std::filesystem::remove_all(workDir, ec);
+        return 1;
+    }
+
+    std::vector<Vec3f> positions;
+    for (const auto& vertex : medium.GetGeometry().vertices)
+        positions.push_back(vertex.position);
+    const Mat4f projection = Mul(Perspective(1.0f, 1.0f, 0.01f, 1000.0f), LookAtLH({0.0f, -100.0f, 0.0f}, {}, {0.0f, 0.0f, 1.0f}));
+    Mat3x4f bone = Mat3x4f::Identity();
+    bone.m[0][3] = 1.0f;
+    std::vector<Vec4f> clip(positions.size());
+    std::vector<Vec3f> skinned(positions.size());
+    runner.Run("TransformPoints/Mat4f/medium", positions.size() * sizeof(Vec3f), [&]() {
+        TransformPoints(projection, positions.data(), positions.size(), sizeof(Vec3f), clip.data());
+        return !clip.empty();
+    });
+    runner.Run("TransformPoints/Mat3x4f/medium", positions.size() * sizeof(Vec3f), [&]() {
+        TransformPoints(bone, positions.data(), positions.size(), sizeof(Vec3f), skinned.data());
+        return !skinned.empty();
+    });
+
+    std::vector<uint8_t> rgba;
+    RenderContext context;
+    for (const int size : {64, 128, 256, 512, 1024})
+    {
+        RenderOptions options{};
+        options.width = size;
+        options.height = size;
+        const std::string suffix = std::to_string(size);
+        runner.Run("RenderThumbnailRgba/medium/" + suffix, 0, [&]() { return RenderThumbnailRgba(medium, options, rgba); });
+        runner.Run("RenderContext/medium/" + suffix, 0, [&]() { return context.Render(medium, options); });
+
+        options.shadingMode = ShadingMode::Visibility;
+        runner.Run("RenderThumbnailRgba/medium/visibility/" + suffix, 0, [&]() { return RenderThumbnailRgba(medium, options, rgba); });
+
+        options.shadingMode = ShadingMode::Forward;
+        options.quality = RenderQuality::Draft;
+        runner.Run("RenderThumbnailRgba/medium/draft/" + suffix, 0, [&]() { return RenderThumbnailRgba(medium, options, rgba); });
+    }
+
+    for (const int size : {256, 1024})
+    {
+        RenderOptions options{};
+        options.width = size;
+        options.height = size;
+        if (!RenderThumbnailRgba(medium, options, rgba))
+            continue;
+        const std::string suffix = std::to_string(size);
+        const auto outPath = workDir / ("out_" + suffix + ".tga");
+        runner.Run("WriteTgaRgba/" + suffix, rgba.size(), [&]() {
+            runner.outputBytes = 18 + rgba.size();
+            return WriteTgaRgba(outPath, size, size, rgba);
+        });
+        runner.Run("WriteTgaRgba/rle/" + suffix, rgba.size(), [&]() {
+            const bool ok = WriteTgaRgba(outPath, size, size, rgba, TgaCompression::Rle);
+            std::error_code sizeEc;
+            runner.outputBytes = static_cast<uint64_t>(std::filesystem::file_size(outPath, sizeEc));
+            return ok;
+        });
+
+        std::vector<uint8_t> qoi;
+        runner.Run("EncodeQoiRgba/" + suffix, rgba.size(), [&]() {
+            const bool ok = EncodeQoiRgba(size, size, rgba, qoi);
+            runner.outputBytes = qoi.size();
+            return ok;
+        });
+
+        std::vector<uint8_t> png;
+        for (const auto& [tier, compression] : {std::pair<const char*, PngCompression>{"stored", PngCompression::Stored},
+                                                 std::pair<const char*, PngCompression>{"fast", PngCompression::Fast},
+                                                 std::pair<const char*, PngCompression>{"best", PngCompression::Best}})
+        {
+            runner.Run(std::string("EncodePngRgba/") + tier + "/" + suffix, rgba.size(), [&]() {
+                const bool ok = EncodePngRgba(size, size, rgba, compression, png);
+                runner.outputBytes = png.size();
+                return ok;
+            });
+        }
+    }
+
+    if (!jsonPath.empty())
+        WriteResultsJson(jsonPath, runner.results);
+
+    std::filesystem::remove_all(workDir, ec);
+    return runner.failed ? 1 : 0;
+}
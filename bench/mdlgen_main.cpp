@@ -0,0 +1,120 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "CrossPlatformMdlExporter/mdl_types.hpp"
+#include "synthetic_mdl.hpp"
+
+namespace
+{
+bool TryParseInt(const std::string& s, int& out)
+{
+    try
+    {
+        size_t pos = 0;
+        const int v = std::stoi(s, &pos, 10);
+        if (pos != s.size())
+            return false;
+        out = v;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool TryParseFloat(const std::string& s, float& out)
+{
+    try
+    {
+        size_t pos = 0;
+        const float v = std::stof(s, &pos);
+        if (pos != s.size())
+            return false;
+        out = v;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: SyntheticMdlGen <output.mdl> [--bones N] [--bodyparts N] [--submodels N] [--meshes N] [--rings N] [--segments N]\n"
+                     "                       [--fan-ratio F] [--textures N] [--texture-width N] [--texture-height N] [--masked] [--separate-textures]\n"
+                     "                       [--chrome] [--additive]\n";
+        return 2;
+    }
+
+    const std::filesystem::path outputPath = std::filesystem::u8path(argv[1]);
+    SyntheticMdlOptions options{};
+
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--masked")
+        {
+            options.maskedTextures = true;
+            continue;
+        }
+        if (arg == "--chrome" || arg == "--additive")
+        {
+            options.lastTextureFlags |= arg == "--chrome" ? STUDIO_NF_CHROME : STUDIO_NF_ADDITIVE;
+            continue;
+        }
+        if (arg == "--separate-textures")
+        {
+            options.separateTextureFile = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << "\n";
+            return 2;
+        }
+
+        const std::string value = argv[++i];
+        bool ok = true;
+        if (arg == "--bones")
+            ok = TryParseInt(value, options.bones);
+        else if (arg == "--bodyparts")
+            ok = TryParseInt(value, options.bodyParts);
+        else if (arg == "--submodels")
+            ok = TryParseInt(value, options.subModels);
+        else if (arg == "--meshes")
+            ok = TryParseInt(value, options.meshesPerModel);
+        else if (arg == "--rings")
+            ok = TryParseInt(value, options.rings);
+        else if (arg == "--segments")
+            ok = TryParseInt(value, options.segments);
+        else if (arg == "--fan-ratio")
+            ok = TryParseFloat(value, options.fanRatio);
+        else if (arg == "--textures")
+            ok = TryParseInt(value, options.textures);
+        else if (arg == "--texture-width")
+            ok = TryParseInt(value, options.textureWidth);
+        else if (arg == "--texture-height")
+            ok = TryParseInt(value, options.textureHeight);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            std::cerr << "Invalid option: " << arg << " " << value << "\n";
+            return 2;
+        }
+    }
+
+    if (!WriteSyntheticMdl(outputPath, options))
+    {
+        std::cerr << "Write mdl failed: " << outputPath.string() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,359 @@
+#include "synthetic_mdl.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "CrossPlatformMdlExporter/mdl_types.hpp"
+
+namespace
+{
+class ByteWriter
+{
+public:
+    int32_t Offset() const { return static_cast<int32_t>(bytes_.size()); }
+
+    template <typename T>
+    int32_t Append(const T* data, size_t count)
+    {
+        Align();
+        const int32_t offset = Offset();
+        const auto* src = reinterpret_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), src, src + sizeof(T) * count);
+        return offset;
+    }
+
+    template <typename T>
+    int32_t Append(const std::vector<T>& data)
+    {
+        return Append(data.data(), data.size());
+    }
+
+    template <typename T>
+    void Patch(int32_t offset, const T& value)
+    {
+        std::memcpy(bytes_.data() + offset, &value, sizeof(T));
+    }
+
+    std::vector<uint8_t> Take() { return std::move(bytes_); }
+
+private:
+    void Align()
+    {
+        while (bytes_.size() % 4 != 0)
+            bytes_.push_back(0);
+    }
+
+    std::vector<uint8_t> bytes_;
+};
+
+void CopyName(char* dst, size_t size, const std::string& name)
+{
+    std::strncpy(dst, name.c_str(), size - 1);
+}
+
+struct SubModelGeometry
+{
+    std::vector<MdlVec3> positions;
+    std::vector<MdlVec3> normals;
+    std::vector<uint8_t> bones;
+    std::vector<std::vector<int16_t>> meshCommands;
+};
+
+// Builds a lat-long ellipsoid around the bone chain. The pole caps are emitted as
+// fans, the ring bands as strips or (per fanRatio) as one quad fan per cell.
+SubModelGeometry BuildSubModel(const SyntheticMdlOptions& options, int bodyPart, int subModel, const std::vector<MdlVec3>& boneOrigins)
+{
+    SubModelGeometry out{};
+
+    const int rings = std::max(2, options.rings);
+    const int segments = std::max(3, options.segments);
+    const float height = 48.0f;
+    const float radius = 10.0f + 2.0f * static_cast<float>(subModel);
+    const float offsetY = 24.0f * static_cast<float>(bodyPart) - 12.0f * static_cast<float>(options.bodyParts - 1);
+    const int boneCount = static_cast<int>(boneOrigins.size());
+
+    auto addVertex = [&](float theta, float phi) -> int16_t {
+        const float nx = std::sin(theta) * std::cos(phi);
+        const float ny = std::sin(theta) * std::sin(phi);
+        const float nz = std::cos(theta);
+        const float z = height * 0.5f * (1.0f - nz);
+        const int bone = std::clamp(static_cast<int>(z / height * static_cast<float>(boneCount)), 0, boneCount - 1);
+        const MdlVec3& origin = boneOrigins[static_cast<size_t>(bone)];
+        out.positions.push_back({radius * nx - origin.x, radius * ny + offsetY - origin.y, z - origin.z});
+        out.normals.push_back({nx, ny, -nz});
+        out.bones.push_back(static_cast<uint8_t>(bone));
+        return static_cast<int16_t>(out.positions.size() - 1);
+    };
+
+    const float pi = 3.14159265f;
+    std::vector<std::vector<int16_t>> grid(static_cast<size_t>(rings + 1));
+    for (int r = 0; r <= rings; r++)
+    {
+        const float theta = pi * static_cast<float>(r) / static_cast<float>(rings);
+        if (r == 0 || r == rings)
+        {
+            grid[static_cast<size_t>(r)].push_back(addVertex(theta, 0.0f));
+            continue;
+        }
+        for (int s = 0; s < segments; s++)
+            grid[static_cast<size_t>(r)].push_back(addVertex(theta, 2.0f * pi * static_cast<float>(s) / static_cast<float>(segments)));
+    }
+
+    const int meshes = std::max(1, options.meshesPerModel);
+    out.meshCommands.resize(static_cast<size_t>(meshes));
+
+    auto texS = [&](int s) { return static_cast<int16_t>(s * options.textureWidth / segments); };
+    auto texT = [&](int r) { return static_cast<int16_t>(r * options.textureHeight / rings); };
+    auto emit = [](std::vector<int16_t>& cmds, int16_t vert, int16_t s, int16_t t) {
+        cmds.push_back(vert);
+        cmds.push_back(vert);
+        cmds.push_back(s);
+        cmds.push_back(t);
+    };
+
+    for (int r = 0; r < rings; r++)
+    {
+        auto& cmds = out.meshCommands[static_cast<size_t>(r * meshes / rings)];
+        const auto& top = grid[static_cast<size_t>(r)];
+        const auto& bottom = grid[static_cast<size_t>(r + 1)];
+
+        if (r == 0 || r == rings - 1)
+        {
+            const bool topCap = r == 0;
+            const auto& ring = topCap ? bottom : top;
+            cmds.push_back(static_cast<int16_t>(-(segments + 2)));
+            emit(cmds, topCap ? top[0] : bottom[0], 0, texT(topCap ? r : r + 1));
+            for (int k = 0; k <= segments; k++)
+            {
+                const int s = topCap ? k : segments - k;
+                emit(cmds, ring[static_cast<size_t>(s % segments)], texS(s), texT(topCap ? r + 1 : r));
+            }
+            continue;
+        }
+
+        const bool fans = options.fanRatio > 0.0f &&
+                          static_cast<int>(static_cast<float>(r) * options.fanRatio) != static_cast<int>(static_cast<float>(r - 1) * options.fanRatio);
+        if (fans)
+        {
+            for (int s = 0; s < segments; s++)
+            {
+                const int s1 = s + 1;
+                cmds.push_back(-4);
+                emit(cmds, top[static_cast<size_t>(s)], texS(s), texT(r));
+                emit(cmds, bottom[static_cast<size_t>(s)], texS(s), texT(r + 1));
+                emit(cmds, bottom[static_cast<size_t>(s1 % segments)], texS(s1), texT(r + 1));
+                emit(cmds, top[static_cast<size_t>(s1 % segments)], texS(s1), texT(r));
+            }
+            continue;
+        }
+
+        cmds.push_back(static_cast<int16_t>(2 * (segments + 1)));
+        for (int s = 0; s <= segments; s++)
+        {
+            emit(cmds, top[static_cast<size_t>(s % segments)], texS(s), texT(r));
+            emit(cmds, bottom[static_cast<size_t>(s % segments)], texS(s), texT(r + 1));
+        }
+    }
+
+    for (auto& cmds : out.meshCommands)
+        cmds.push_back(0);
+    return out;
+}
+
+std::vector<uint8_t> BuildTexturePixels(const SyntheticMdlOptions& options, int textureIndex)
+{
+    const int w = std::max(1, options.textureWidth);
+    const int h = std::max(1, options.textureHeight);
+    std::vector<uint8_t> out(static_cast<size_t>(w) * static_cast<size_t>(h) + 256 * 3);
+
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int index = ((x / 8) + (y / 8) + textureIndex) % 2 == 0 ? (x * 127 / w) : 128 + (y * 126 / h);
+            if (options.maskedTextures && ((x / 4) + (y / 4)) % 5 == 0)
+                index = 255;
+            out[static_cast<size_t>(y) * static_cast<size_t>(w) + static_cast<size_t>(x)] = static_cast<uint8_t>(index);
+        }
+    }
+
+    uint8_t* palette = out.data() + static_cast<size_t>(w) * static_cast<size_t>(h);
+    for (int i = 0; i < 256; i++)
+    {
+        palette[i * 3 + 0] = static_cast<uint8_t>((i * 2 + textureIndex * 60) & 0xff);
+        palette[i * 3 + 1] = static_cast<uint8_t>(255 - i);
+        palette[i * 3 + 2] = static_cast<uint8_t>((i * 5 + 40) & 0xff);
+    }
+    return out;
+}
+
+void WriteTextures(ByteWriter& writer, StudioHdr& header, const SyntheticMdlOptions& options)
+{
+    std::vector<MStudioTexture> textures(static_cast<size_t>(std::max(1, options.textures)));
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        auto& tex = textures[i];
+        CopyName(tex.name, sizeof(tex.name), "synthetic" + std::to_string(i) + ".bmp");
+        tex.flags = options.maskedTextures ? STUDIO_NF_MASKED : 0;
+        if (i + 1 == textures.size())
+            tex.flags |= options.lastTextureFlags;
+        tex.width = std::max(1, options.textureWidth);
+        tex.height = std::max(1, options.textureHeight);
+        tex.index = writer.Append(BuildTexturePixels(options, static_cast<int>(i)));
+    }
+
+    std::vector<uint16_t> skins(textures.size());
+    for (size_t i = 0; i < skins.size(); i++)
+        skins[i] = static_cast<uint16_t>(i);
+
+    header.numtextures = static_cast<int32_t>(textures.size());
+    header.textureindex = writer.Append(textures);
+    header.texturedataindex = textures.front().index;
+    header.numskinref = static_cast<int32_t>(skins.size());
+    header.numskinfamilies = 1;
+    header.skinindex = writer.Append(skins);
+}
+} // namespace
+
+SyntheticMdlFiles BuildSyntheticMdl(const SyntheticMdlOptions& options)
+{
+    SyntheticMdlFiles out{};
+
+    // Tricmds address vertices with int16.
+    const int64_t verticesPerModel = static_cast<int64_t>(std::max(2, options.rings) - 1) * std::max(3, options.segments) + 2;
+    if (verticesPerModel > 32767)
+        return out;
+
+    ByteWriter writer;
+    StudioHdr header{};
+    header.id = StudioId_IDST;
+    header.version = StudioVersion;
+    CopyName(header.name, sizeof(header.name), "synthetic.mdl");
+    writer.Append(&header, 1);
+
+    const int boneCount = std::max(1, options.bones);
+    std::vector<MStudioBone> bones(static_cast<size_t>(boneCount));
+    std::vector<MdlVec3> boneOrigins(bones.size());
+    const float boneStep = 48.0f / static_cast<float>(boneCount);
+    for (int i = 0; i < boneCount; i++)
+    {
+        auto& bone = bones[static_cast<size_t>(i)];
+        CopyName(bone.name, sizeof(bone.name), "bone" + std::to_string(i));
+        bone.parent = i - 1;
+        bone.value[2] = i == 0 ? 0.0f : boneStep;
+        for (int c = 0; c < 6; c++)
+            bone.bonecontroller[c] = -1;
+        boneOrigins[static_cast<size_t>(i)] = {0.0f, 0.0f, boneStep * static_cast<float>(i)};
+    }
+    header.numbones = boneCount;
+    header.boneindex = writer.Append(bones);
+
+    const int bodyPartCount = std::max(1, options.bodyParts);
+    const int subModelCount = std::max(1, options.subModels);
+    const float maxRadius = 10.0f + 2.0f * static_cast<float>(subModelCount - 1);
+    const float spanY = 12.0f * static_cast<float>(bodyPartCount - 1);
+
+    MStudioSeqDesc seq{};
+    CopyName(seq.label, sizeof(seq.label), "idle");
+    seq.fps = 30.0f;
+    seq.numframes = 1;
+    seq.numblends = 1;
+    seq.bbmin[0] = -maxRadius;
+    seq.bbmin[1] = -maxRadius - spanY;
+    seq.bbmin[2] = 0.0f;
+    seq.bbmax[0] = maxRadius;
+    seq.bbmax[1] = maxRadius + spanY;
+    seq.bbmax[2] = 48.0f;
+    header.numseq = 1;
+    header.seqindex = writer.Append(&seq, 1);
+    header.numseqgroups = 1;
+    header.bbmin = {seq.bbmin[0], seq.bbmin[1], seq.bbmin[2]};
+    header.bbmax = {seq.bbmax[0], seq.bbmax[1], seq.bbmax[2]};
+
+    std::vector<MStudioBodyParts> bodyParts(static_cast<size_t>(bodyPartCount));
+    const int textureCount = std::max(1, options.textures);
+    for (int bp = 0; bp < bodyPartCount; bp++)
+    {
+        std::vector<MStudioModel> models(static_cast<size_t>(subModelCount));
+        for (int sm = 0; sm < subModelCount; sm++)
+        {
+            const auto geometry = BuildSubModel(options, bp, sm, boneOrigins);
+            auto& model = models[static_cast<size_t>(sm)];
+            CopyName(model.name, sizeof(model.name), "part" + std::to_string(bp) + "_" + std::to_string(sm));
+            model.boundingradius = maxRadius;
+            model.numverts = static_cast<int32_t>(geometry.positions.size());
+            model.vertinfoindex = writer.Append(geometry.bones);
+            model.vertindex = writer.Append(geometry.positions);
+            model.numnorms = static_cast<int32_t>(geometry.normals.size());
+            model.norminfoindex = writer.Append(geometry.bones);
+            model.normindex = writer.Append(geometry.normals);
+
+            std::vector<MStudioMesh> meshes(geometry.meshCommands.size());
+            for (size_t m = 0; m < meshes.size(); m++)
+            {
+                meshes[m].triindex = writer.Append(geometry.meshCommands[m]);
+                meshes[m].skinref = static_cast<int32_t>(m) % textureCount;
+                meshes[m].numnorms = model.numnorms;
+            }
+            model.nummesh = static_cast<int32_t>(meshes.size());
+            model.meshindex = writer.Append(meshes);
+        }
+
+        auto& bodyPart = bodyParts[static_cast<size_t>(bp)];
+        CopyName(bodyPart.name, sizeof(bodyPart.name), "body" + std::to_string(bp));
+        bodyPart.nummodels = subModelCount;
+        bodyPart.base = 1;
+        bodyPart.modelindex = writer.Append(models);
+    }
+    header.numbodyparts = bodyPartCount;
+    header.bodypartindex = writer.Append(bodyParts);
+
+    if (options.separateTextureFile)
+    {
+        ByteWriter textureWriter;
+        StudioHdr textureHeader{};
+        textureHeader.id = StudioId_IDST;
+        textureHeader.version = StudioVersion;
+        CopyName(textureHeader.name, sizeof(textureHeader.name), "syntheticT.mdl");
+        textureWriter.Append(&textureHeader, 1);
+        WriteTextures(textureWriter, textureHeader, options);
+        textureHeader.length = textureWriter.Offset();
+        textureWriter.Patch(0, textureHeader);
+        out.textures = textureWriter.Take();
+    }
+    else
+    {
+        WriteTextures(writer, header, options);
+    }
+
+    header.length = writer.Offset();
+    writer.Patch(0, header);
+    out.model = writer.Take();
+    return out;
+}
+
+bool WriteSyntheticMdl(const std::filesystem::path& filePath, const SyntheticMdlOptions& options)
+{
+    const auto files = BuildSyntheticMdl(options);
+    if (files.model.empty())
+        return false;
+
+    auto writeFile = [](const std::filesystem::path& path, const std::vector<uint8_t>& bytes) -> bool {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out);
+    };
+
+    if (!writeFile(filePath, files.model))
+        return false;
+    if (files.textures.empty())
+        return true;
+
+    const auto texturePath = filePath.parent_path() / (filePath.stem().string() + "T" + filePath.extension().string());
+    return writeFile(texturePath, files.textures);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Shape of a generated IDST v10 model. Every submodel is a textured ellipsoid of
+// (rings - 1) * segments + 2 vertices skinned to a chain of bones.
+struct SyntheticMdlOptions
+{
+    int bones{4};
+    int bodyParts{1};
+    int subModels{1};
+    int meshesPerModel{2};
+    int rings{16};
+    int segments{24};
+    // Fraction of ring bands emitted as one 4-vertex fan per quad instead of a strip.
+    // The pole caps are always fans.
+    float fanRatio{0.25f};
+    int textures{2};
+    int textureWidth{64};
+    int textureHeight{64};
+    bool maskedTextures{false};
+    // Extra MStudioTexture flags for the last texture, e.g. STUDIO_NF_CHROME or STUDIO_NF_ADDITIVE.
+    int32_t lastTextureFlags{};
+    // Write the textures into a companion <name>T.mdl instead of the model file.
+    bool separateTextureFile{false};
+};
+
+struct SyntheticMdlFiles
+{
+    std::vector<uint8_t> model;
+    std::vector<uint8_t> textures;
+};
+
+SyntheticMdlFiles BuildSyntheticMdl(const SyntheticMdlOptions& options);
+bool WriteSyntheticMdl(const std::filesystem::path& filePath, const SyntheticMdlOptions& options);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+// Non-owning view of `size` contiguous elements. Builds from anything with data() and size(),
+// including a view of non-const elements.
+template <typename T>
+class ArrayView
+{
+public:
+    ArrayView() = default;
+    ArrayView(T* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename Container>
+    ArrayView(Container&& container) : data_(container.data()), size_(container.size())
+    {
+    }
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t i) const { return data_[i]; }
+
+private:
+    T* data_{};
+    size_t size_{};
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/mdl_model.hpp"
+
+struct AtlasOptions
+{
+    // Texels around every texture, filled by repeating its edge so bilinear filtering and
+    // small mip levels don't bleed neighbours in.
+    int padding{2};
+    // The packer tries power-of-two widths up to this and keeps the smallest area.
+    int maxWidth{4096};
+};
+
+struct AtlasRect
+{
+    // Index into the model list passed to BuildTextureAtlas and into that model's textures.
+    int source{};
+    int texture{};
+    // Texel rectangle of level 0, padding excluded.
+    int x{};
+    int y{};
+    int width{};
+    int height{};
+};
+
+struct TextureAtlas
+{
+    int width{};
+    int height{};
+    int padding{};
+    std::vector<uint8_t> rgba;
+    std::vector<AtlasRect> rects;
+};
+
+// Skyline bottom-left packing of the given sizes (tallest first) into a bin `binWidth` wide.
+// `placed` keeps the input order; width/height are the extent actually used.
+bool PackSkyline(const std::vector<AtlasRect>& sizes, int binWidth, std::vector<AtlasRect>& placed, int& width, int& height);
+
+// Packs every texture of every model into one row-major RGBA image.
+bool BuildTextureAtlas(const std::vector<const StudioModelCpu*>& models, const AtlasOptions& options, TextureAtlas& atlas);
+
+const AtlasRect* FindAtlasRect(const TextureAtlas& atlas, int source, int texture);
+
+// Maps texture coordinates of `source`'s meshes into atlas space. Vertices shared by meshes
+// with different textures are duplicated first. Returns false if some coordinate lies
+// outside [0, 1], i.e. the mesh relies on texture wrapping, which an atlas can't reproduce.
+bool RemapTexCoordsToAtlas(const TextureAtlas& atlas, int source, ModelGeometry& geometry);
+
+// {"width":..,"height":..,"padding":..,"sources":[file names],"textures":[{"source":..,"texture":..,"name":..,"x":..,"y":..,"w":..,"h":..,
+// "uvScale":[..],"uvOffset":[..],"wraps":..}, ...]}. uv' = uv * uvScale + uvOffset; "wraps" marks textures
+// whose meshes use coordinates outside [0, 1].
+void WriteAtlasJson(std::ostream& out, const TextureAtlas& atlas, const std::vector<const StudioModelCpu*>& models);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <filesystem>
+#include <ostream>
+
+#include "CrossPlatformMdlExporter/mdl_model.hpp"
+#include "CrossPlatformMdlExporter/png_encoder.hpp"
+
+struct GlbExportOptions
+{
+    // Embedded textures are PNG.
+    PngCompression textureCompression{PngCompression::Best};
+    // GoldSrc shows one submodel per body part (the renderer uses the first); with this set
+    // every submodel becomes its own node.
+    bool allSubmodels{false};
+};
+
+// Binary glTF 2.0: one node and mesh per exported submodel, one primitive per studio mesh,
+// POSITION/NORMAL/TEXCOORD_0 shared by the primitives of a submodel, one material and
+// embedded PNG per texture. Coordinates are converted from GoldSrc Z-up to glTF Y-up and
+// triangles from clockwise to counter-clockwise front faces. Vertex and index data are
+// converted and streamed into the BIN chunk through a small fixed buffer.
+bool WriteGlb(std::ostream& out, const StudioModelCpu& model, const GlbExportOptions& options = {}, Profiler* profiler = nullptr);
+bool WriteGlb(const std::filesystem::path& filePath, const StudioModelCpu& model, const GlbExportOptions& options = {}, Profiler* profiler = nullptr);
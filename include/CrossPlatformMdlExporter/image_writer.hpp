@@ -2,8 +2,73 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <fstream>
 #include <vector>
 
-bool WriteTgaRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba);
-bool WriteImageAuto(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba);
+#include "CrossPlatformMdlExporter/png_encoder.hpp"
+#include "CrossPlatformMdlExporter/profiler.hpp"
+#include "CrossPlatformMdlExporter/qoi_encoder.hpp"
+
+// TGA stores 16-bit dimensions.
+constexpr int kMaxTgaDimension = 65535;
+
+enum class TgaCompression : uint32_t
+{
+    // Image type 2.
+    None = 0,
+    // Image type 10: per-scanline run-length packets. Flat backgrounds shrink to a few bytes per row.
+    Rle = 1,
+};
+
+// Writes a top-down 32-bit TGA a band of rows at a time, so the whole image never has to be
+// in memory. Rows are converted to BGRA in bulk and written in blocks of about a megabyte.
+class TgaStreamWriter
+{
+public:
+    // The block buffers are charged to MemoryTag::Encoder of `profiler`.
+    bool Open(const std::filesystem::path& filePath, int width, int height, TgaCompression compression = TgaCompression::None, Profiler* profiler = nullptr);
+    bool WriteRows(const uint8_t* rgba, int rows);
+    // Fails unless exactly `height` rows were written.
+    bool Close();
+
+private:
+    std::ofstream out_;
+    int width_{};
+    int height_{};
+    int rowsWritten_{};
+    TgaCompression compression_{};
+    std::vector<uint8_t> encoded_;
+    std::vector<uint8_t> scratch_;
+    TrackedMemory memory_;
+};
+
+bool WriteTgaRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, TgaCompression compression = TgaCompression::None,
+                  Profiler* profiler = nullptr);
+// Whole TGA file (header included) into `out`.
+bool EncodeTgaRgba(int width, int height, const std::vector<uint8_t>& rgba, TgaCompression compression, std::vector<uint8_t>& out, Profiler* profiler = nullptr);
+
+enum class ImageFormat : uint32_t
+{
+    Tga = 0,
+    Png = 1,
+    Qoi = 2,
+};
+
+// .png is Png, .qoi is Qoi, anything else Tga.
+ImageFormat ImageFormatFromPath(const std::filesystem::path& filePath);
+
+struct ImageWriteOptions
+{
+    PngCompression pngCompression{PngCompression::Best};
+    TgaCompression tgaCompression{TgaCompression::None};
+};
+
+// Encodes to memory instead of a file, e.g. for piping to stdout or uploading directly.
+bool EncodeImage(ImageFormat format, int width, int height, const std::vector<uint8_t>& rgba, const ImageWriteOptions& options, std::vector<uint8_t>& out,
+                 Profiler* profiler = nullptr);
+bool WriteImage(const std::filesystem::path& filePath, ImageFormat format, int width, int height, const std::vector<uint8_t>& rgba, const ImageWriteOptions& options = {},
+                Profiler* profiler = nullptr);
+// Picks the format from the extension: .png, .qoi, otherwise .tga.
+bool WriteImageAuto(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, const ImageWriteOptions& options = {},
+                    Profiler* profiler = nullptr);
 
@@ -3,7 +3,17 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPME_MATH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define CPME_MATH_NEON 1
+#include <arm_neon.h>
+#endif
 
 struct Vec2f
 {
@@ -52,7 +62,57 @@ inline Vec3f Normalize(const Vec3f& v)
     return v / len;
 }
 
-struct Mat4f
+// Four-lane float vector: SSE2 or NEON register, plain array otherwise. Products and sums are
+// rounded separately (no fused multiply-add) so every backend gives the scalar results.
+namespace simd
+{
+#if defined(CPME_MATH_SSE2)
+using Float4 = __m128;
+
+inline Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+inline Float4 Splat(float s) { return _mm_set1_ps(s); }
+inline Float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+#elif defined(CPME_MATH_NEON)
+using Float4 = float32x4_t;
+
+inline Float4 Load(const float* p) { return vld1q_f32(p); }
+inline void Store(float* p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 Splat(float s) { return vdupq_n_f32(s); }
+inline Float4 Set(float x, float y, float z, float w)
+{
+    const float lanes[4] = {x, y, z, w};
+    return vld1q_f32(lanes);
+}
+inline Float4 Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 Min(Float4 a, Float4 b) { return vminq_f32(a, b); }
+inline Float4 Max(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+#else
+struct Float4
+{
+    float v[4];
+};
+
+inline Float4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void Store(float* p, Float4 v) { std::memcpy(p, v.v, sizeof(v.v)); }
+inline Float4 Splat(float s) { return {{s, s, s, s}}; }
+inline Float4 Set(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+inline Float4 Add(Float4 a, Float4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+inline Float4 Mul(Float4 a, Float4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+inline Float4 Min(Float4 a, Float4 b) { return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}}; }
+inline Float4 Max(Float4 a, Float4 b) { return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}}; }
+#endif
+
+// a * b + c
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return Add(Mul(a, b), c); }
+} // namespace simd
+
+struct alignas(16) Mat4f
 {
     std::array<float, 16> m{};
 
@@ -67,20 +127,39 @@ struct Mat4f
     }
 };
 
+// Affine transform (rotation | translation) as three 16-byte rows, the layout of GoldSrc bone
+// matrices.
+struct alignas(16) Mat3x4f
+{
+    float m[3][4]{};
+
+    static Mat3x4f Identity()
+    {
+        Mat3x4f r{};
+        r.m[0][0] = 1.0f;
+        r.m[1][1] = 1.0f;
+        r.m[2][2] = 1.0f;
+        return r;
+    }
+};
+
+// Row i of a * b is sum_k a[i][k] * row k of b.
 inline Mat4f Mul(const Mat4f& a, const Mat4f& b)
 {
+    const simd::Float4 b0 = simd::Load(&b.m[0]);
+    const simd::Float4 b1 = simd::Load(&b.m[4]);
+    const simd::Float4 b2 = simd::Load(&b.m[8]);
+    const simd::Float4 b3 = simd::Load(&b.m[12]);
+
     Mat4f r{};
     for (int row = 0; row < 4; row++)
     {
-        for (int col = 0; col < 4; col++)
-        {
-            float sum = 0.0f;
-            for (int k = 0; k < 4; k++)
-            {
-                sum += a.m[row * 4 + k] * b.m[k * 4 + col];
-            }
-            r.m[row * 4 + col] = sum;
-        }
+        const float* ar = &a.m[static_cast<size_t>(row * 4)];
+        simd::Float4 sum = simd::Mul(simd::Splat(ar[0]), b0);
+        sum = simd::MulAdd(simd::Splat(ar[1]), b1, sum);
+        sum = simd::MulAdd(simd::Splat(ar[2]), b2, sum);
+        sum = simd::MulAdd(simd::Splat(ar[3]), b3, sum);
+        simd::Store(&r.m[static_cast<size_t>(row * 4)], sum);
     }
     return r;
 }
@@ -95,6 +174,90 @@ inline Vec4f Mul(const Mat4f& a, const Vec4f& v)
     };
 }
 
+// a * b with b's implicit fourth row (0, 0, 0, 1), i.e. b applied first.
+inline Mat3x4f Concat(const Mat3x4f& a, const Mat3x4f& b)
+{
+    const simd::Float4 b0 = simd::Load(b.m[0]);
+    const simd::Float4 b1 = simd::Load(b.m[1]);
+    const simd::Float4 b2 = simd::Load(b.m[2]);
+
+    Mat3x4f r{};
+    for (int row = 0; row < 3; row++)
+    {
+        const float* ar = a.m[row];
+        simd::Float4 sum = simd::Mul(simd::Splat(ar[0]), b0);
+        sum = simd::MulAdd(simd::Splat(ar[1]), b1, sum);
+        sum = simd::MulAdd(simd::Splat(ar[2]), b2, sum);
+        sum = simd::Add(sum, simd::Set(0.0f, 0.0f, 0.0f, ar[3]));
+        simd::Store(r.m[row], sum);
+    }
+    return r;
+}
+
+inline Vec3f TransformPoint(const Mat3x4f& m, const Vec3f& p)
+{
+    return {
+        p.x * m.m[0][0] + p.y * m.m[0][1] + p.z * m.m[0][2] + m.m[0][3],
+        p.x * m.m[1][0] + p.y * m.m[1][1] + p.z * m.m[1][2] + m.m[1][3],
+        p.x * m.m[2][0] + p.y * m.m[2][1] + p.z * m.m[2][2] + m.m[2][3],
+    };
+}
+
+inline Vec3f TransformDirection(const Mat3x4f& m, const Vec3f& d)
+{
+    return {
+        d.x * m.m[0][0] + d.y * m.m[0][1] + d.z * m.m[0][2],
+        d.x * m.m[1][0] + d.y * m.m[1][1] + d.z * m.m[1][2],
+        d.x * m.m[2][0] + d.y * m.m[2][1] + d.z * m.m[2][2],
+    };
+}
+
+// Batched kernels: the matrix is transposed into four column registers once, then every point
+// costs three broadcasts and multiply-adds. `stride` is the byte distance between input points
+// so positions can be read straight out of vertex structs. Input and output may alias.
+inline void TransformPoints(const Mat3x4f& m, const Vec3f* points, size_t count, size_t stride, Vec3f* out)
+{
+    const simd::Float4 c0 = simd::Set(m.m[0][0], m.m[1][0], m.m[2][0], 0.0f);
+    const simd::Float4 c1 = simd::Set(m.m[0][1], m.m[1][1], m.m[2][1], 0.0f);
+    const simd::Float4 c2 = simd::Set(m.m[0][2], m.m[1][2], m.m[2][2], 0.0f);
+    const simd::Float4 c3 = simd::Set(m.m[0][3], m.m[1][3], m.m[2][3], 0.0f);
+
+    const auto* src = reinterpret_cast<const unsigned char*>(points);
+    for (size_t i = 0; i < count; i++, src += stride)
+    {
+        const Vec3f p = *reinterpret_cast<const Vec3f*>(src);
+        simd::Float4 r = simd::Mul(simd::Splat(p.x), c0);
+        r = simd::MulAdd(simd::Splat(p.y), c1, r);
+        r = simd::MulAdd(simd::Splat(p.z), c2, r);
+        r = simd::Add(r, c3);
+        alignas(16) float lanes[4];
+        simd::Store(lanes, r);
+        out[i] = {lanes[0], lanes[1], lanes[2]};
+    }
+}
+
+// Points are taken as (x, y, z, 1).
+inline void TransformPoints(const Mat4f& m, const Vec3f* points, size_t count, size_t stride, Vec4f* out)
+{
+    const simd::Float4 c0 = simd::Set(m.m[0], m.m[4], m.m[8], m.m[12]);
+    const simd::Float4 c1 = simd::Set(m.m[1], m.m[5], m.m[9], m.m[13]);
+    const simd::Float4 c2 = simd::Set(m.m[2], m.m[6], m.m[10], m.m[14]);
+    const simd::Float4 c3 = simd::Set(m.m[3], m.m[7], m.m[11], m.m[15]);
+
+    const auto* src = reinterpret_cast<const unsigned char*>(points);
+    for (size_t i = 0; i < count; i++, src += stride)
+    {
+        const Vec3f p = *reinterpret_cast<const Vec3f*>(src);
+        simd::Float4 r = simd::Mul(simd::Splat(p.x), c0);
+        r = simd::MulAdd(simd::Splat(p.y), c1, r);
+        r = simd::MulAdd(simd::Splat(p.z), c2, r);
+        r = simd::Add(r, c3);
+        alignas(16) float lanes[4];
+        simd::Store(lanes, r);
+        out[i] = {lanes[0], lanes[1], lanes[2], lanes[3]};
+    }
+}
+
 inline Mat4f Perspective(float fovYRadians, float aspect, float zNear, float zFar)
 {
     const float f = 1.0f / std::tan(fovYRadians * 0.5f);
@@ -5,14 +5,10 @@
 #include <string>
 #include <vector>
 
+#include "CrossPlatformMdlExporter/array_view.hpp"
 #include "CrossPlatformMdlExporter/math.hpp"
-
-struct TextureRgba
-{
-    int width{};
-    int height{};
-    std::vector<uint8_t> rgba;
-};
+#include "CrossPlatformMdlExporter/profiler.hpp"
+#include "CrossPlatformMdlExporter/texture.hpp"
 
 struct Vertex
 {
@@ -29,31 +25,77 @@ struct Vertex
     }
 };
 
+// One studio mesh: a run of ModelGeometry::indices drawn with one texture. The indices are
+// relative to the submodel's first vertex.
 struct Mesh
 {
     int textureId{-1};
-    std::vector<uint32_t> indices;
+    uint32_t firstIndex{};
+    uint32_t indexCount{};
 };
 
+// One submodel: runs of ModelGeometry::vertices and ::meshes.
 struct Model
 {
-    std::vector<Vertex> vertices;
-    std::vector<Mesh> meshes;
+    uint32_t firstVertex{};
+    uint32_t vertexCount{};
+    uint32_t firstMesh{};
+    uint32_t meshCount{};
 };
 
+// Runs of ModelGeometry::models.
 struct BodyPart
 {
+    uint32_t firstModel{};
+    uint32_t modelCount{};
+};
+
+// All decoded geometry of a file in flat arrays, in body part / submodel / mesh order, with the
+// descriptors above pointing into them by offset so the whole thing stays copyable.
+struct ModelGeometry
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Mesh> meshes;
     std::vector<Model> models;
+    std::vector<BodyPart> bodyParts;
+
+    ArrayView<const Model> Models(const BodyPart& bodyPart) const { return {models.data() + bodyPart.firstModel, bodyPart.modelCount}; }
+    ArrayView<const Mesh> Meshes(const Model& model) const { return {meshes.data() + model.firstMesh, model.meshCount}; }
+    ArrayView<const Vertex> Vertices(const Model& model) const { return {vertices.data() + model.firstVertex, model.vertexCount}; }
+    ArrayView<Vertex> Vertices(const Model& model) { return {vertices.data() + model.firstVertex, model.vertexCount}; }
+    ArrayView<const uint32_t> Indices(const Mesh& mesh) const { return {indices.data() + mesh.firstIndex, mesh.indexCount}; }
+    ArrayView<uint32_t> Indices(const Mesh& mesh) { return {indices.data() + mesh.firstIndex, mesh.indexCount}; }
+};
+
+struct LoadOptions
+{
+    TextureLayout textureLayout{TextureLayout::RowMajor};
+    // Reorder each mesh's triangles for post-transform cache reuse and each model's vertices
+    // to match.
+    bool optimizeVertexCache{false};
+    // Geometry only: the companion <name>T.mdl is never opened and no texture is decoded.
+    bool skipTextures{false};
+};
+
+// FIFO post-transform cache misses summed over all meshes, before and after the
+// LoadOptions::optimizeVertexCache pass. Zero when the pass is off.
+struct VertexCacheStats
+{
+    uint64_t triangles{};
+    uint64_t missesBefore{};
+    uint64_t missesAfter{};
 };
 
 class StudioModelCpu
 {
 public:
-    bool LoadFromFile(const std::filesystem::path& filePath);
+    bool LoadFromFile(const std::filesystem::path& filePath, const LoadOptions& options = {}, Profiler* profiler = nullptr);
 
     const std::filesystem::path& GetFilePath() const { return filePath_; }
-    const std::vector<BodyPart>& GetBodyParts() const { return bodyParts_; }
+    const ModelGeometry& GetGeometry() const { return geometry_; }
     const std::vector<TextureRgba>& GetTextures() const { return textures_; }
+    const VertexCacheStats& GetVertexCacheStats() const { return vertexCacheStats_; }
 
     Vec3f GetBoundsMin() const { return boundsMin_; }
     Vec3f GetBoundsMax() const { return boundsMax_; }
@@ -66,9 +108,15 @@ private:
     const uint8_t* base_{};
     const uint8_t* textureBase_{};
 
-    std::vector<BodyPart> bodyParts_{};
+    ModelGeometry geometry_{};
     std::vector<TextureRgba> textures_{};
+    VertexCacheStats vertexCacheStats_{};
 
     Vec3f boundsMin_{};
     Vec3f boundsMax_{};
+
+    // Charged to the profiler passed to LoadFromFile.
+    TrackedMemory fileMemory_{};
+    TrackedMemory textureMemory_{};
+    TrackedMemory geometryMemory_{};
 };
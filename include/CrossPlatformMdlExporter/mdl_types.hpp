@@ -179,4 +179,6 @@ static constexpr int32_t StudioId_IDSQ = 0x51534449;
 
 static constexpr int32_t StudioVersion = 10;
 
+static constexpr int32_t STUDIO_NF_CHROME = 0x0002;
+static constexpr int32_t STUDIO_NF_ADDITIVE = 0x0020;
 static constexpr int32_t STUDIO_NF_MASKED = 0x0040;
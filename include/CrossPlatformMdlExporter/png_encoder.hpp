@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/profiler.hpp"
+
+enum class PngCompression : uint32_t
+{
+    // Deflate stored blocks, no filtering. Fastest, no size reduction.
+    Stored = 0,
+    // Run-length matches (previous byte / previous pixel) coded with the fixed Huffman table.
+    Fast = 1,
+    // Hash-chain LZ77 with per-block dynamic Huffman tables.
+    Best = 2,
+};
+
+uint32_t UpdateCrc32(uint32_t crc, const uint8_t* data, size_t size);
+uint32_t UpdateAdler32(uint32_t adler, const uint8_t* data, size_t size);
+
+// 8-bit RGBA, non-interlaced. Each scanline gets the PNG filter with the smallest sum of
+// absolute residuals (Stored keeps every row unfiltered). The filtered scanlines, the zlib
+// stream and `out` are charged to MemoryTag::Encoder for the duration of the call.
+bool EncodePngRgba(int width, int height, const std::vector<uint8_t>& rgba, PngCompression compression, std::vector<uint8_t>& out, Profiler* profiler = nullptr);
+bool WritePngRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, PngCompression compression = PngCompression::Best,
+                  Profiler* profiler = nullptr);
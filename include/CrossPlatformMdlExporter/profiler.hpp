@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ProfileStage : uint32_t
+{
+    FileRead = 0,
+    Validation,
+    TextureDecode,
+    MeshDecode,
+    BoneTransforms,
+    VertexTransform,
+    TriangleSetup,
+    Rasterization,
+    Shading,
+    Encode,
+    Count,
+};
+
+const char* GetProfileStageName(ProfileStage stage);
+
+enum class MemoryTag : uint32_t
+{
+    // Raw .mdl / texture / sequence file contents.
+    FileData = 0,
+    // Decoded RGBA textures with their mip chains, and texture atlases.
+    Textures,
+    // Decoded vertices and indices.
+    Geometry,
+    // Colour, depth and visibility buffers plus the per-frame vertex and triangle setup buffers.
+    RenderTargets,
+    // Encoder working sets, encoded output and resampled copies.
+    Encoder,
+    Count,
+};
+
+const char* GetMemoryTagName(MemoryTag tag);
+
+// One finished span of a trace; times are relative to the profiler's creation.
+struct TraceEvent
+{
+    const char* name{};
+    // File, texture or body part the span worked on; may be empty.
+    std::string detail;
+    uint64_t startNs{};
+    uint64_t durationNs{};
+    uint64_t items{};
+    uint32_t threadId{};
+};
+
+// Small sequential id of the calling thread: 1 for the first thread that asks, 2 for the next.
+uint32_t GetTraceThreadId();
+
+// Per-stage wall time, number of timed calls and a stage-specific item count
+// (bytes, texels, vertices, triangles or pixels), plus current and peak bytes held per
+// memory tag, and optionally every individual span for a trace. Safe to update from several
+// threads.
+class Profiler
+{
+public:
+    struct StageTotals
+    {
+        uint64_t nanoseconds{};
+        uint64_t calls{};
+        uint64_t items{};
+    };
+
+    struct MemoryTotals
+    {
+        uint64_t current{};
+        uint64_t peak{};
+    };
+
+    void Add(ProfileStage stage, uint64_t nanoseconds, uint64_t items)
+    {
+        auto& s = stages_[static_cast<size_t>(stage)];
+        s.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        s.calls.fetch_add(1, std::memory_order_relaxed);
+        s.items.fetch_add(items, std::memory_order_relaxed);
+    }
+
+    StageTotals Get(ProfileStage stage) const
+    {
+        const auto& s = stages_[static_cast<size_t>(stage)];
+        return {s.nanoseconds.load(std::memory_order_relaxed), s.calls.load(std::memory_order_relaxed), s.items.load(std::memory_order_relaxed)};
+    }
+
+    void Allocate(MemoryTag tag, uint64_t bytes)
+    {
+        auto& m = memory_[static_cast<size_t>(tag)];
+        RaisePeak(m.peak, m.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        RaisePeak(totalMemory_.peak, totalMemory_.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    }
+
+    void Release(MemoryTag tag, uint64_t bytes)
+    {
+        memory_[static_cast<size_t>(tag)].current.fetch_sub(bytes, std::memory_order_relaxed);
+        totalMemory_.current.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    MemoryTotals GetMemory(MemoryTag tag) const
+    {
+        const auto& m = memory_[static_cast<size_t>(tag)];
+        return {m.current.load(std::memory_order_relaxed), m.peak.load(std::memory_order_relaxed)};
+    }
+
+    // The peak of the sum, which is at most the sum of the per-tag peaks.
+    MemoryTotals GetTotalMemory() const
+    {
+        return {totalMemory_.current.load(std::memory_order_relaxed), totalMemory_.peak.load(std::memory_order_relaxed)};
+    }
+
+    // Keeps every ScopedProfile and ScopedTrace span from now on. Call before the profiler is
+    // shared with other threads.
+    void EnableTrace() { tracing_ = true; }
+    bool IsTracing() const { return tracing_; }
+
+    void AddTraceEvent(const char* name, std::string detail, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, uint64_t items)
+    {
+        TraceEvent event{name, std::move(detail), ToNanoseconds(start - origin_), ToNanoseconds(end - start), items, GetTraceThreadId()};
+        std::lock_guard<std::mutex> lock(traceMutex_);
+        trace_.push_back(std::move(event));
+    }
+
+    std::vector<TraceEvent> GetTraceEvents() const
+    {
+        std::lock_guard<std::mutex> lock(traceMutex_);
+        return trace_;
+    }
+
+private:
+    struct Stage
+    {
+        std::atomic<uint64_t> nanoseconds{};
+        std::atomic<uint64_t> calls{};
+        std::atomic<uint64_t> items{};
+    };
+
+    struct Memory
+    {
+        std::atomic<uint64_t> current{};
+        std::atomic<uint64_t> peak{};
+    };
+
+    static uint64_t ToNanoseconds(std::chrono::steady_clock::duration d)
+    {
+        return static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+
+    static void RaisePeak(std::atomic<uint64_t>& peak, uint64_t value)
+    {
+        uint64_t seen = peak.load(std::memory_order_relaxed);
+        while (seen < value && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::array<Stage, static_cast<size_t>(ProfileStage::Count)> stages_{};
+    std::array<Memory, static_cast<size_t>(MemoryTag::Count)> memory_{};
+    Memory totalMemory_{};
+
+    const std::chrono::steady_clock::time_point origin_{std::chrono::steady_clock::now()};
+    bool tracing_{false};
+    mutable std::mutex traceMutex_;
+    std::vector<TraceEvent> trace_;
+};
+
+// Times the enclosing scope into `profiler`; does nothing when profiler is null.
+class ScopedProfile
+{
+public:
+    ScopedProfile(Profiler* profiler, ProfileStage stage, uint64_t items = 0) : profiler_(profiler), stage_(stage), items_(items)
+    {
+        if (profiler_)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedProfile()
+    {
+        if (!profiler_)
+            return;
+        const auto end = std::chrono::steady_clock::now();
+        profiler_->Add(stage_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count()), items_);
+        if (profiler_->IsTracing())
+            profiler_->AddTraceEvent(GetProfileStageName(stage_), {}, start_, end, items_);
+    }
+
+    ScopedProfile(const ScopedProfile&) = delete;
+    ScopedProfile& operator=(const ScopedProfile&) = delete;
+
+    void SetItems(uint64_t items) { items_ = items; }
+
+private:
+    Profiler* profiler_{};
+    ProfileStage stage_{};
+    uint64_t items_{};
+    std::chrono::steady_clock::time_point start_{};
+};
+
+// Records the enclosing scope as a trace span named `name` (a string literal) when `profiler`
+// traces; does nothing otherwise. Unlike ScopedProfile it adds nothing to the stage totals, so
+// it can mark finer or coarser units of work (one texture, one body part, a whole load).
+class ScopedTrace
+{
+public:
+    ScopedTrace(Profiler* profiler, const char* name, std::string detail = {}) : profiler_(profiler && profiler->IsTracing() ? profiler : nullptr), name_(name)
+    {
+        if (!profiler_)
+            return;
+        detail_ = std::move(detail);
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTrace()
+    {
+        if (profiler_)
+            profiler_->AddTraceEvent(name_, std::move(detail_), start_, std::chrono::steady_clock::now(), 0);
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    Profiler* profiler_{};
+    const char* name_{};
+    std::string detail_;
+    std::chrono::steady_clock::time_point start_{};
+};
+
+// Charges `bytes` to `tag` of `profiler` for as long as it lives; Set() re-measures the owner
+// after its buffers grew or shrank. Copies charge the same bytes again, moves transfer them.
+// Does nothing when profiler is null.
+class TrackedMemory
+{
+public:
+    TrackedMemory() = default;
+    TrackedMemory(Profiler* profiler, MemoryTag tag, uint64_t bytes = 0) { Reset(profiler, tag, bytes); }
+    ~TrackedMemory() { Reset(nullptr, tag_, 0); }
+
+    TrackedMemory(const TrackedMemory& other) { Reset(other.profiler_, other.tag_, other.bytes_); }
+    TrackedMemory& operator=(const TrackedMemory& other)
+    {
+        if (this != &other)
+            Reset(other.profiler_, other.tag_, other.bytes_);
+        return *this;
+    }
+
+    TrackedMemory(TrackedMemory&& other) noexcept : profiler_(other.profiler_), tag_(other.tag_), bytes_(other.bytes_) { other.profiler_ = nullptr; }
+    TrackedMemory& operator=(TrackedMemory&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset(nullptr, tag_, 0);
+            profiler_ = other.profiler_;
+            tag_ = other.tag_;
+            bytes_ = other.bytes_;
+            other.profiler_ = nullptr;
+        }
+        return *this;
+    }
+
+    void Reset(Profiler* profiler, MemoryTag tag, uint64_t bytes)
+    {
+        if (profiler_)
+            profiler_->Release(tag_, bytes_);
+        if (profiler)
+            profiler->Allocate(tag, bytes);
+        profiler_ = profiler;
+        tag_ = tag;
+        bytes_ = profiler ? bytes : 0;
+    }
+
+    void Set(uint64_t bytes) { Reset(profiler_, tag_, bytes); }
+
+private:
+    Profiler* profiler_{};
+    MemoryTag tag_{};
+    uint64_t bytes_{};
+};
+
+// Bytes reserved by a vector, which is what it actually holds on to.
+template <typename T>
+uint64_t CapacityBytes(const std::vector<T>& v)
+{
+    return static_cast<uint64_t>(v.capacity()) * sizeof(T);
+}
+
+void WriteProfileTable(std::ostream& out, const Profiler& profiler);
+// Current and peak bytes per memory tag; also the tail of WriteProfileTable.
+void WriteMemoryTable(std::ostream& out, const Profiler& profiler);
+void WriteProfileJson(std::ostream& out, const Profiler& profiler);
+// Chrome / Perfetto trace-event JSON of the recorded spans: complete ("X") events in
+// microseconds, one tid per thread, detail and item count in args.
+void WriteTraceJson(std::ostream& out, const Profiler& profiler);
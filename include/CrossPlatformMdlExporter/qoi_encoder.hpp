@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/profiler.hpp"
+
+// "Quite OK Image" format: RGBA, sRGB colour space with linear alpha. One pass over the
+// pixels with a 64-entry colour cache; much smaller than raw TGA at a similar cost. Ops go
+// through a 64 KiB chunk that is appended to `out` or written to the file as it fills.
+bool EncodeQoiRgba(int width, int height, const std::vector<uint8_t>& rgba, std::vector<uint8_t>& out, Profiler* profiler = nullptr);
+bool WriteQoiRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, Profiler* profiler = nullptr);
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include "CrossPlatformMdlExporter/math.hpp"
 #include "CrossPlatformMdlExporter/mdl_model.hpp"
+#include "CrossPlatformMdlExporter/profiler.hpp"
 
 enum class BackgroundPreset : uint32_t
 {
@@ -13,18 +16,111 @@ enum class BackgroundPreset : uint32_t
     Transparent = 2,
 };
 
+enum class TextureFilter : uint32_t
+{
+    Bilinear = 0,
+    NearestMip = 1,
+    Trilinear = 2,
+};
+
+enum class ShadingMode : uint32_t
+{
+    // Texture and blend every fragment that passes the depth test.
+    Forward = 0,
+    // Rasterize depth plus triangle id first, then shade each visible pixel once.
+    Visibility = 1,
+};
+
+enum class RenderQuality : uint32_t
+{
+    Full = 0,
+    // Untextured preview for triage: depth plus one grey per triangle from its facing, drawn
+    // forward regardless of shadingMode and lighting. A corner marker flags the image as a
+    // draft. Pairs with LoadOptions::skipTextures.
+    Draft = 1,
+};
+
 struct RenderOptions
 {
     int width{256};
     int height{256};
     BackgroundPreset background{BackgroundPreset::Blue};
+    TextureFilter textureFilter{TextureFilter::Bilinear};
+    ShadingMode shadingMode{ShadingMode::Forward};
+    // GoldSrc-style per-vertex Lambert plus ambient; off renders the unlit texture colour.
+    bool lighting{false};
+    // Rotation of the model about the vertical axis through its bounds centre.
+    float yawDegrees{};
+    RenderQuality quality{RenderQuality::Full};
 };
 
 struct RenderStats
 {
     size_t triangles{};
     size_t degenerateTriangles{};
+    size_t pixelsShaded{};
     size_t pixelsWritten{};
 };
 
-bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& options, std::vector<uint8_t>& outRgba, RenderStats* stats = nullptr);
+// Receives one finished band of a banded render: `rows` rows of RGBA8 starting at image row
+// `y`, options.width pixels wide. Returning false stops the render.
+using RenderBandSink = std::function<bool(int y, int rows, const uint8_t* rgba)>;
+
+// Owns the colour, depth and scratch buffers of a render and keeps them between calls, so
+// repeated renders at the same (or a smaller) size do not touch the heap. Not thread safe;
+// use one context per thread.
+class RenderContext
+{
+public:
+    RenderContext();
+    ~RenderContext();
+    RenderContext(RenderContext&&) noexcept;
+    RenderContext& operator=(RenderContext&&) noexcept;
+    RenderContext(const RenderContext&) = delete;
+    RenderContext& operator=(const RenderContext&) = delete;
+
+    bool Render(const StudioModelCpu& model, const RenderOptions& options, RenderStats* stats = nullptr, Profiler* profiler = nullptr);
+    // Renders the image as horizontal bands of `bandRows` rows, each with its own colour and
+    // depth slice and only the triangles whose bounds touch it, and hands every band to `sink`
+    // top to bottom. Memory is bounded by width * bandRows instead of the full frame.
+    bool RenderBanded(const StudioModelCpu& model,
+                      const RenderOptions& options,
+                      int bandRows,
+                      const RenderBandSink& sink,
+                      RenderStats* stats = nullptr,
+                      Profiler* profiler = nullptr);
+
+    int GetWidth() const { return width_; }
+    int GetHeight() const { return height_; }
+    // RGBA8 result of the last Render, width * height * 4 bytes (the last band after RenderBanded).
+    const std::vector<uint8_t>& GetRgba() const;
+    // Moves the last result out; the next Render allocates a new colour buffer.
+    std::vector<uint8_t> ReleaseRgba();
+
+private:
+    struct Buffers;
+
+    void SetupTriangles(const StudioModelCpu& model, const RenderOptions& options, RenderStats* stats, Profiler* profiler);
+    void DrawBand(const RenderOptions& options, bool binned, int minY, int maxY, RenderStats* stats, Profiler* profiler);
+
+    std::unique_ptr<Buffers> buffers_;
+    int width_{};
+    int height_{};
+};
+
+bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& options, std::vector<uint8_t>& outRgba, RenderStats* stats = nullptr, Profiler* profiler = nullptr);
+
+// Evenly spaced yaw angles for a full turntable, starting at 0.
+std::vector<float> MakeTurntableYaws(int views);
+
+// Renders one view per yaw angle into a sprite sheet of options.width x options.height
+// cells, row by row, `columns` per row (0 picks a near-square grid). Views render in parallel.
+bool RenderSpriteSheetRgba(const StudioModelCpu& model,
+                           const RenderOptions& options,
+                           const std::vector<float>& yawDegrees,
+                           int columns,
+                           std::vector<uint8_t>& outRgba,
+                           int& outWidth,
+                           int& outHeight,
+                           RenderStats* stats = nullptr,
+                           Profiler* profiler = nullptr);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Area-averaging box filter for shrinking RGBA images. Colour is averaged with
+// premultiplied alpha, so transparent background texels don't darken the edges.
+bool DownscaleRgba(const std::vector<uint8_t>& src, int srcWidth, int srcHeight, std::vector<uint8_t>& dst, int dstWidth, int dstHeight);
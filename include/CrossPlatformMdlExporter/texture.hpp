@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TextureLayout : uint32_t
+{
+    RowMajor = 0,
+    // 4x4 texel blocks stored contiguously, blocks in row-major order. Both
+    // dimensions are padded up to a multiple of 4.
+    Tiled4x4 = 1,
+};
+
+struct TextureMipLevel
+{
+    int width{};
+    int height{};
+    std::vector<uint8_t> rgba;
+};
+
+struct TextureRgba
+{
+    int width{};
+    int height{};
+    std::vector<uint8_t> rgba;
+
+    // Levels 1..N of the mip chain; level 0 is width/height/rgba above.
+    std::vector<TextureMipLevel> mips;
+
+    // Storage order of rgba and every mip level.
+    TextureLayout layout{TextureLayout::RowMajor};
+
+    // MStudioTexture::name and ::flags of the source texture.
+    std::string name;
+    int32_t flags{};
+
+    // True when every texel has alpha 255, so sampled colours can be stored without blending.
+    bool opaque{true};
+};
+
+struct TextureLevelView
+{
+    int width{};
+    int height{};
+    const uint8_t* rgba{};
+};
+
+inline int GetMipLevelCount(const TextureRgba& texture) { return 1 + static_cast<int>(texture.mips.size()); }
+
+inline TextureLevelView GetMipLevel(const TextureRgba& texture, int level)
+{
+    if (level <= 0 || texture.mips.empty())
+        return {texture.width, texture.height, texture.rgba.data()};
+    const auto& mip = texture.mips[static_cast<size_t>(std::min(level, static_cast<int>(texture.mips.size())) - 1)];
+    return {mip.width, mip.height, mip.rgba.data()};
+}
+
+template <TextureLayout Layout>
+inline size_t TexelIndex(int width, int x, int y)
+{
+    if constexpr (Layout == TextureLayout::Tiled4x4)
+    {
+        const size_t tilesX = static_cast<size_t>(width + 3) >> 2;
+        const size_t tile = static_cast<size_t>(y >> 2) * tilesX + static_cast<size_t>(x >> 2);
+        return tile * 16 + static_cast<size_t>((y & 3) * 4 + (x & 3));
+    }
+    else
+    {
+        return static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
+    }
+}
+
+inline size_t GetTexelStorageCount(TextureLayout layout, int width, int height)
+{
+    if (layout == TextureLayout::Tiled4x4)
+        return static_cast<size_t>((width + 3) & ~3) * static_cast<size_t>((height + 3) & ~3);
+    return static_cast<size_t>(width) * static_cast<size_t>(height);
+}
+
+void BuildMipChain(TextureRgba& texture);
+
+// Re-orders level 0 and every mip level into the requested layout.
+void SetTextureLayout(TextureRgba& texture, TextureLayout layout);
@@ -0,0 +1,338 @@
+#include "CrossPlatformMdlExporter/atlas.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+struct SkylineNode
+{
+    int x{};
+    int y{};
+    int width{};
+};
+
+// Lowest y at which a rectangle `width` wide can sit with its left edge on node `index`, or
+// -1 if it would stick out of the bin.
+int FitSkyline(const std::vector<SkylineNode>& skyline, size_t index, int width, int binWidth)
+{
+    const int x = skyline[index].x;
+    if (x + width > binWidth)
+        return -1;
+
+    int y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0 && i < skyline.size(); i++)
+    {
+        y = std::max(y, skyline[i].y);
+        remaining -= skyline[i].width;
+    }
+    return y;
+}
+
+void AddSkylineLevel(std::vector<SkylineNode>& skyline, size_t index, int x, int y, int width)
+{
+    skyline.insert(skyline.begin() + static_cast<std::ptrdiff_t>(index), {x, y, width});
+
+    // Trim or drop the nodes the new one now covers.
+    for (size_t i = index + 1; i < skyline.size();)
+    {
+        const int covered = x + width - skyline[i].x;
+        if (covered <= 0)
+            break;
+        if (covered < skyline[i].width)
+        {
+            skyline[i].x += covered;
+            skyline[i].width -= covered;
+            break;
+        }
+        skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+
+    for (size_t i = 0; i + 1 < skyline.size();)
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i + 1));
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+const uint8_t* TexelAt(const TextureRgba& texture, int x, int y)
+{
+    const size_t index = texture.layout == TextureLayout::Tiled4x4 ? TexelIndex<TextureLayout::Tiled4x4>(texture.width, x, y) : TexelIndex<TextureLayout::RowMajor>(texture.width, x, y);
+    return texture.rgba.data() + index * 4;
+}
+
+// Copies the texture with its edge texels repeated `padding` times on every side.
+void BlitPadded(const TextureRgba& texture, int padding, const AtlasRect& rect, TextureAtlas& atlas)
+{
+    for (int y = -padding; y < texture.height + padding; y++)
+    {
+        const int sy = std::clamp(y, 0, texture.height - 1);
+        uint8_t* dst = atlas.rgba.data() + (static_cast<size_t>(rect.y + y) * static_cast<size_t>(atlas.width) + static_cast<size_t>(rect.x - padding)) * 4;
+        for (int x = -padding; x < texture.width + padding; x++, dst += 4)
+            std::memcpy(dst, TexelAt(texture, std::clamp(x, 0, texture.width - 1), sy), 4);
+    }
+}
+
+bool IsWrapping(const Vec2f& uv)
+{
+    constexpr float kEpsilon = 1.0e-4f;
+    return uv.x < -kEpsilon || uv.y < -kEpsilon || uv.x > 1.0f + kEpsilon || uv.y > 1.0f + kEpsilon;
+}
+
+std::string EscapeJson(const std::string& s)
+{
+    std::string out;
+    for (const char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+    return out;
+}
+
+Vec2f ToAtlasUv(const TextureAtlas& atlas, const AtlasRect& rect, const Vec2f& uv)
+{
+    return {(static_cast<float>(rect.x) + uv.x * static_cast<float>(rect.width)) / static_cast<float>(atlas.width),
+            (static_cast<float>(rect.y) + uv.y * static_cast<float>(rect.height)) / static_cast<float>(atlas.height)};
+}
+} // namespace
+
+bool PackSkyline(const std::vector<AtlasRect>& sizes, int binWidth, std::vector<AtlasRect>& placed, int& width, int& height)
+{
+    placed = sizes;
+    width = 0;
+    height = 0;
+
+    std::vector<size_t> order(sizes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sizes[a].height != sizes[b].height ? sizes[a].height > sizes[b].height : sizes[a].width > sizes[b].width;
+    });
+
+    std::vector<SkylineNode> skyline{{0, 0, binWidth}};
+    for (const size_t r : order)
+    {
+        auto& rect = placed[r];
+        if (rect.width <= 0 || rect.height <= 0)
+            return false;
+
+        size_t bestNode = skyline.size();
+        int bestTop = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < skyline.size(); i++)
+        {
+            const int y = FitSkyline(skyline, i, rect.width, binWidth);
+            if (y >= 0 && y + rect.height < bestTop)
+            {
+                bestNode = i;
+                bestTop = y + rect.height;
+            }
+        }
+        if (bestNode == skyline.size())
+            return false;
+
+        rect.x = skyline[bestNode].x;
+        rect.y = bestTop - rect.height;
+        AddSkylineLevel(skyline, bestNode, rect.x, bestTop, rect.width);
+        width = std::max(width, rect.x + rect.width);
+        height = std::max(height, bestTop);
+    }
+    return true;
+}
+
+bool BuildTextureAtlas(const std::vector<const StudioModelCpu*>& models, const AtlasOptions& options, TextureAtlas& atlas)
+{
+    atlas = {};
+    atlas.padding = std::max(0, options.padding);
+
+    std::vector<AtlasRect> sizes;
+    int widest = 0;
+    int tallest = 0;
+    for (size_t m = 0; m < models.size(); m++)
+    {
+        const auto& textures = models[m]->GetTextures();
+        for (size_t t = 0; t < textures.size(); t++)
+        {
+            if (textures[t].width <= 0 || textures[t].height <= 0)
+                continue;
+            AtlasRect rect{};
+            rect.source = static_cast<int>(m);
+            rect.texture = static_cast<int>(t);
+            rect.width = textures[t].width + atlas.padding * 2;
+            rect.height = textures[t].height + atlas.padding * 2;
+            widest = std::max(widest, rect.width);
+            tallest = std::max(tallest, rect.height);
+            sizes.push_back(rect);
+        }
+    }
+    if (sizes.empty() || widest > options.maxWidth)
+        return false;
+
+    // Candidate widths: multiples of the widest texture (padding makes power-of-two textures
+    // slightly wider than a power of two) and powers of two, up to maxWidth. The smallest
+    // resulting area wins, ties go to the squarer atlas.
+    std::vector<int> widths;
+    for (int w = widest; w <= options.maxWidth; w += widest)
+        widths.push_back(w);
+    for (int w = 1; w <= options.maxWidth; w *= 2)
+    {
+        if (w > widest)
+            widths.push_back(w);
+    }
+    std::sort(widths.begin(), widths.end());
+    widths.erase(std::unique(widths.begin(), widths.end()), widths.end());
+
+    uint64_t bestArea = std::numeric_limits<uint64_t>::max();
+    int bestAspect = std::numeric_limits<int>::max();
+    for (const int binWidth : widths)
+    {
+        std::vector<AtlasRect> placed;
+        int usedWidth = 0;
+        int usedHeight = 0;
+        if (!PackSkyline(sizes, binWidth, placed, usedWidth, usedHeight))
+            continue;
+        const uint64_t usedArea = static_cast<uint64_t>(usedWidth) * static_cast<uint64_t>(usedHeight);
+        const int aspect = std::abs(usedWidth - usedHeight);
+        if (usedArea < bestArea || (usedArea == bestArea && aspect < bestAspect))
+        {
+            bestArea = usedArea;
+            bestAspect = aspect;
+            atlas.width = usedWidth;
+            atlas.height = usedHeight;
+            atlas.rects = std::move(placed);
+        }
+        // Once everything fits in a single row, wider bins only add empty space.
+        if (usedHeight == tallest)
+            break;
+    }
+    if (atlas.rects.empty())
+        return false;
+
+    atlas.rgba.assign(static_cast<size_t>(atlas.width) * static_cast<size_t>(atlas.height) * 4, 0);
+    for (auto& rect : atlas.rects)
+    {
+        rect.x += atlas.padding;
+        rect.y += atlas.padding;
+        rect.width -= atlas.padding * 2;
+        rect.height -= atlas.padding * 2;
+        BlitPadded(models[static_cast<size_t>(rect.source)]->GetTextures()[static_cast<size_t>(rect.texture)], atlas.padding, rect, atlas);
+    }
+    return true;
+}
+
+const AtlasRect* FindAtlasRect(const TextureAtlas& atlas, int source, int texture)
+{
+    for (const auto& rect : atlas.rects)
+    {
+        if (rect.source == source && rect.texture == texture)
+            return &rect;
+    }
+    return nullptr;
+}
+
+bool RemapTexCoordsToAtlas(const TextureAtlas& atlas, int source, ModelGeometry& geometry)
+{
+    bool inRange = true;
+    // Copies grow their submodel's vertex run, so the vertex array is rebuilt submodel by
+    // submodel.
+    std::vector<Vertex> vertices;
+    vertices.reserve(geometry.vertices.size());
+    for (auto& model : geometry.models)
+    {
+        const auto firstVertex = static_cast<uint32_t>(vertices.size());
+        const auto original = geometry.Vertices(model);
+        vertices.insert(vertices.end(), original.begin(), original.end());
+
+        // Each vertex is claimed by the texture of the first mesh that uses it; other
+        // textures get their own copy.
+        std::vector<int> owner(model.vertexCount, -1);
+        std::unordered_map<uint64_t, uint32_t> copies;
+        for (const auto& mesh : geometry.Meshes(model))
+        {
+            for (auto& index : geometry.Indices(mesh))
+            {
+                if (owner[index] == -1 || owner[index] == mesh.textureId)
+                {
+                    owner[index] = mesh.textureId;
+                    continue;
+                }
+                const uint64_t key = (static_cast<uint64_t>(index) << 32) | static_cast<uint32_t>(mesh.textureId);
+                const auto it = copies.find(key);
+                if (it != copies.end())
+                {
+                    index = it->second;
+                    continue;
+                }
+                const auto copy = static_cast<uint32_t>(vertices.size() - firstVertex);
+                vertices.push_back(original[index]);
+                owner.push_back(mesh.textureId);
+                copies.emplace(key, copy);
+                index = copy;
+            }
+        }
+
+        for (size_t v = 0; v < owner.size(); v++)
+        {
+            const AtlasRect* rect = owner[v] >= 0 ? FindAtlasRect(atlas, source, owner[v]) : nullptr;
+            if (rect == nullptr)
+                continue;
+            Vertex& vertex = vertices[firstVertex + v];
+            if (IsWrapping(vertex.texCoord))
+                inRange = false;
+            vertex.texCoord = ToAtlasUv(atlas, *rect, vertex.texCoord);
+        }
+        model.firstVertex = firstVertex;
+        model.vertexCount = static_cast<uint32_t>(vertices.size() - firstVertex);
+    }
+    geometry.vertices.swap(vertices);
+    return inRange;
+}
+
+void WriteAtlasJson(std::ostream& out, const TextureAtlas& atlas, const std::vector<const StudioModelCpu*>& models)
+{
+    out << "{\"width\":" << atlas.width << ",\"height\":" << atlas.height << ",\"padding\":" << atlas.padding << ",\"sources\":[";
+    for (size_t i = 0; i < models.size(); i++)
+        out << (i > 0 ? "," : "") << "\"" << EscapeJson(models[i]->GetFilePath().filename().u8string()) << "\"";
+    out << "],\"textures\":[";
+    for (size_t i = 0; i < atlas.rects.size(); i++)
+    {
+        const auto& rect = atlas.rects[i];
+        const auto* model = models[static_cast<size_t>(rect.source)];
+
+        bool wraps = false;
+        const ModelGeometry& geometry = model->GetGeometry();
+        for (const auto& m : geometry.models)
+        {
+            const auto vertices = geometry.Vertices(m);
+            for (const auto& mesh : geometry.Meshes(m))
+            {
+                if (mesh.textureId != rect.texture)
+                    continue;
+                for (const uint32_t index : geometry.Indices(mesh))
+                    wraps = wraps || IsWrapping(vertices[index].texCoord);
+            }
+        }
+
+        if (i > 0)
+            out << ",";
+        out << "{\"source\":" << rect.source << ",\"texture\":" << rect.texture << ",\"name\":\"" << EscapeJson(model->GetTextures()[static_cast<size_t>(rect.texture)].name) << "\",\"x\":" << rect.x << ",\"y\":" << rect.y
+            << ",\"w\":" << rect.width << ",\"h\":" << rect.height << ",\"uvScale\":[" << static_cast<double>(rect.width) / atlas.width << ","
+            << static_cast<double>(rect.height) / atlas.height << "],\"uvOffset\":[" << static_cast<double>(rect.x) / atlas.width << ","
+            << static_cast<double>(rect.y) / atlas.height << "],\"wraps\":" << (wraps ? "true" : "false") << "}";
+    }
+    out << "]}\n";
+}
@@ -0,0 +1,358 @@
+#include "CrossPlatformMdlExporter/gltf_exporter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/mdl_types.hpp"
+
+namespace
+{
+constexpr uint32_t kArrayBuffer = 34962;
+constexpr uint32_t kElementArrayBuffer = 34963;
+constexpr uint32_t kUnsignedShort = 5123;
+constexpr uint32_t kUnsignedInt = 5125;
+constexpr uint32_t kFloat = 5126;
+
+struct ExportedModel
+{
+    ArrayView<const Vertex> vertices;
+    ArrayView<const Mesh> meshes;
+    std::string name;
+    bool shortIndices{};
+    size_t positionOffset{};
+    size_t normalOffset{};
+    size_t uvOffset{};
+    // One per mesh; SIZE_MAX for meshes without triangles.
+    std::vector<size_t> indexOffsets;
+};
+
+struct ExportedImage
+{
+    std::vector<uint8_t> png;
+    size_t offset{};
+};
+
+// GoldSrc is right-handed Z-up with X forward; glTF is right-handed Y-up with +Z forward.
+// A cyclic permutation of the axes keeps the handedness.
+Vec3f ToGltfAxes(const Vec3f& v) { return {v.y, v.z, v.x}; }
+
+size_t Align4(size_t n) { return (n + 3) & ~size_t{3}; }
+
+std::string EscapeJson(const std::string& s)
+{
+    std::string out;
+    for (const char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+    return out;
+}
+
+std::vector<uint8_t> ToRowMajor(const TextureRgba& texture)
+{
+    if (texture.layout == TextureLayout::RowMajor)
+        return texture.rgba;
+
+    std::vector<uint8_t> rgba(static_cast<size_t>(texture.width) * static_cast<size_t>(texture.height) * 4);
+    for (int y = 0; y < texture.height; y++)
+    {
+        for (int x = 0; x < texture.width; x++)
+            std::memcpy(&rgba[(static_cast<size_t>(y) * static_cast<size_t>(texture.width) + static_cast<size_t>(x)) * 4], &texture.rgba[TexelIndex<TextureLayout::Tiled4x4>(texture.width, x, y) * 4], 4);
+    }
+    return rgba;
+}
+
+// Fixed-size staging buffer between the converted arrays and the stream.
+class ChunkWriter
+{
+public:
+    explicit ChunkWriter(std::ostream& out)
+        : out_(out)
+    {
+        buffer_.reserve(kCapacity);
+    }
+
+    void Put(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        if (buffer_.size() + size > kCapacity)
+            Flush();
+        if (size >= kCapacity)
+        {
+            out_.write(reinterpret_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+            return;
+        }
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    void PadTo4(size_t written)
+    {
+        static const uint8_t zeros[4] = {};
+        Put(zeros, Align4(written) - written);
+    }
+
+    uint64_t CapacityBytes() const { return ::CapacityBytes(buffer_); }
+
+    void Flush()
+    {
+        out_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+private:
+    static constexpr size_t kCapacity = 64 * 1024;
+    std::ostream& out_;
+    std::vector<uint8_t> buffer_;
+};
+
+void PutU32(std::ostream& out, uint32_t v)
+{
+    const uint8_t bytes[4] = {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 24)};
+    out.write(reinterpret_cast<const char*>(bytes), 4);
+}
+} // namespace
+
+bool WriteGlb(std::ostream& out, const StudioModelCpu& model, const GlbExportOptions& options, Profiler* profiler)
+{
+    ScopedTrace trace(profiler, "WriteGlb", model.GetFilePath().filename().u8string());
+    const auto& textures = model.GetTextures();
+
+    std::vector<ExportedModel> exported;
+    const ModelGeometry& geometry = model.GetGeometry();
+    for (size_t b = 0; b < geometry.bodyParts.size(); b++)
+    {
+        const auto models = geometry.Models(geometry.bodyParts[b]);
+        const size_t count = options.allSubmodels ? models.size() : std::min<size_t>(1, models.size());
+        for (size_t s = 0; s < count; s++)
+        {
+            ExportedModel e{};
+            e.vertices = geometry.Vertices(models[s]);
+            e.meshes = geometry.Meshes(models[s]);
+            const bool hasTriangles = std::any_of(e.meshes.begin(), e.meshes.end(), [](const Mesh& mesh) { return mesh.indexCount >= 3; });
+            if (e.vertices.empty() || !hasTriangles)
+                continue;
+            e.name = "bodypart" + std::to_string(b) + "_submodel" + std::to_string(s);
+            e.shortIndices = e.vertices.size() <= std::numeric_limits<uint16_t>::max();
+            exported.push_back(e);
+        }
+    }
+    if (exported.empty())
+        return false;
+
+    std::vector<ExportedImage> images(textures.size());
+    TrackedMemory imageMemory(profiler, MemoryTag::Encoder);
+    uint64_t imageBytes = 0;
+    for (size_t t = 0; t < textures.size(); t++)
+    {
+        if (!EncodePngRgba(textures[t].width, textures[t].height, ToRowMajor(textures[t]), options.textureCompression, images[t].png, profiler))
+            return false;
+        imageBytes += CapacityBytes(images[t].png);
+        imageMemory.Set(imageBytes);
+    }
+
+    // BIN chunk layout: per submodel positions, normals, uvs, then its index lists; then the
+    // images. Every view starts on a 4-byte boundary.
+    size_t binSize = 0;
+    for (auto& e : exported)
+    {
+        const size_t vertexCount = e.vertices.size();
+        e.positionOffset = binSize;
+        binSize += vertexCount * 12;
+        e.normalOffset = binSize;
+        binSize += vertexCount * 12;
+        e.uvOffset = binSize;
+        binSize += vertexCount * 8;
+        for (const auto& mesh : e.meshes)
+        {
+            const size_t triangleIndices = mesh.indexCount / 3 * 3;
+            e.indexOffsets.push_back(triangleIndices == 0 ? std::numeric_limits<size_t>::max() : binSize);
+            binSize = Align4(binSize + triangleIndices * (e.shortIndices ? 2 : 4));
+        }
+    }
+    for (auto& image : images)
+    {
+        image.offset = binSize;
+        binSize = Align4(binSize + image.png.size());
+    }
+
+    std::ostringstream json;
+    json.imbue(std::locale::classic());
+    json << std::setprecision(9);
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"CrossPlatformMdlExporter\"},\"scene\":0,\"scenes\":[{\"name\":\""
+         << EscapeJson(model.GetFilePath().stem().u8string()) << "\",\"nodes\":[";
+    for (size_t i = 0; i < exported.size(); i++)
+        json << (i > 0 ? "," : "") << i;
+    json << "]}],\"nodes\":[";
+    for (size_t i = 0; i < exported.size(); i++)
+        json << (i > 0 ? "," : "") << "{\"name\":\"" << exported[i].name << "\",\"mesh\":" << i << "}";
+
+    // Views and accessors are numbered in the order they're listed here.
+    std::ostringstream views;
+    std::ostringstream accessors;
+    size_t viewCount = 0;
+    auto addView = [&](size_t offset, size_t length, uint32_t target) {
+        views << (viewCount > 0 ? "," : "") << "{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << length;
+        if (target != 0)
+            views << ",\"target\":" << target;
+        views << "}";
+        return viewCount++;
+    };
+    size_t accessorCount = 0;
+    auto addAccessor = [&](size_t view, uint32_t componentType, size_t count, const char* type) {
+        accessors << (accessorCount > 0 ? "," : "") << "{\"bufferView\":" << view << ",\"componentType\":" << componentType << ",\"count\":" << count << ",\"type\":\"" << type << "\"";
+        return accessorCount++;
+    };
+
+    json << "],\"meshes\":[";
+    for (size_t i = 0; i < exported.size(); i++)
+    {
+        const auto& e = exported[i];
+        const auto& vertices = e.vertices;
+
+        Vec3f minP{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        Vec3f maxP{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+        for (const auto& v : vertices)
+        {
+            const Vec3f p = ToGltfAxes(v.position);
+            minP = {std::min(minP.x, p.x), std::min(minP.y, p.y), std::min(minP.z, p.z)};
+            maxP = {std::max(maxP.x, p.x), std::max(maxP.y, p.y), std::max(maxP.z, p.z)};
+        }
+
+        const size_t position = addAccessor(addView(e.positionOffset, vertices.size() * 12, kArrayBuffer), kFloat, vertices.size(), "VEC3");
+        accessors << ",\"min\":[" << minP.x << "," << minP.y << "," << minP.z << "],\"max\":[" << maxP.x << "," << maxP.y << "," << maxP.z << "]}";
+        const size_t normal = addAccessor(addView(e.normalOffset, vertices.size() * 12, kArrayBuffer), kFloat, vertices.size(), "VEC3");
+        accessors << "}";
+        const size_t uv = addAccessor(addView(e.uvOffset, vertices.size() * 8, kArrayBuffer), kFloat, vertices.size(), "VEC2");
+        accessors << "}";
+
+        json << (i > 0 ? "," : "") << "{\"name\":\"" << e.name << "\",\"primitives\":[";
+        bool firstPrimitive = true;
+        for (size_t mi = 0; mi < e.meshes.size(); mi++)
+        {
+            if (e.indexOffsets[mi] == std::numeric_limits<size_t>::max())
+                continue;
+            const auto& mesh = e.meshes[mi];
+            const size_t count = mesh.indexCount / 3 * 3;
+            const size_t indices = addAccessor(addView(e.indexOffsets[mi], count * (e.shortIndices ? 2 : 4), kElementArrayBuffer), e.shortIndices ? kUnsignedShort : kUnsignedInt, count, "SCALAR");
+            accessors << "}";
+
+            json << (firstPrimitive ? "" : ",") << "{\"attributes\":{\"POSITION\":" << position << ",\"NORMAL\":" << normal << ",\"TEXCOORD_0\":" << uv << "},\"indices\":" << indices;
+            if (mesh.textureId >= 0 && mesh.textureId < static_cast<int>(textures.size()))
+                json << ",\"material\":" << mesh.textureId;
+            json << ",\"mode\":4}";
+            firstPrimitive = false;
+        }
+        json << "]}";
+    }
+    json << "]";
+
+    for (const auto& image : images)
+        addView(image.offset, image.png.size(), 0);
+
+    if (!textures.empty())
+    {
+        // Materials, textures and images share the studio texture index. Chrome has no glTF
+        // equivalent and is exported as a plain texture.
+        json << ",\"materials\":[";
+        for (size_t t = 0; t < textures.size(); t++)
+        {
+            json << (t > 0 ? "," : "") << "{\"name\":\"" << EscapeJson(textures[t].name) << "\",\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":" << t
+                 << "},\"metallicFactor\":0,\"roughnessFactor\":1}";
+            if ((textures[t].flags & STUDIO_NF_ADDITIVE) != 0)
+                json << ",\"alphaMode\":\"BLEND\"";
+            else if (!textures[t].opaque)
+                json << ",\"alphaMode\":\"MASK\",\"alphaCutoff\":0.5";
+            json << "}";
+        }
+        json << "],\"samplers\":[{\"magFilter\":9729,\"minFilter\":9987,\"wrapS\":10497,\"wrapT\":10497}],\"textures\":[";
+        for (size_t t = 0; t < textures.size(); t++)
+            json << (t > 0 ? "," : "") << "{\"sampler\":0,\"source\":" << t << "}";
+        json << "],\"images\":[";
+        const size_t firstImageView = viewCount - images.size();
+        for (size_t t = 0; t < textures.size(); t++)
+            json << (t > 0 ? "," : "") << "{\"bufferView\":" << firstImageView + t << ",\"mimeType\":\"image/png\"}";
+        json << "]";
+    }
+
+    json << ",\"accessors\":[" << accessors.str() << "],\"bufferViews\":[" << views.str() << "],\"buffers\":[{\"byteLength\":" << binSize << "}]}";
+
+    std::string jsonText = json.str();
+    jsonText.resize(Align4(jsonText.size()), ' ');
+    const uint64_t totalSize = 12 + 8 + jsonText.size() + 8 + binSize;
+    if (totalSize > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    out.write("glTF", 4);
+    PutU32(out, 2);
+    PutU32(out, static_cast<uint32_t>(totalSize));
+    PutU32(out, static_cast<uint32_t>(jsonText.size()));
+    out.write("JSON", 4);
+    out.write(jsonText.data(), static_cast<std::streamsize>(jsonText.size()));
+    PutU32(out, static_cast<uint32_t>(binSize));
+    out.write("BIN\0", 4);
+
+    ChunkWriter bin(out);
+    const TrackedMemory binMemory(profiler, MemoryTag::Encoder, bin.CapacityBytes());
+    for (const auto& e : exported)
+    {
+        for (const auto& v : e.vertices)
+        {
+            const Vec3f p = ToGltfAxes(v.position);
+            bin.Put(&p, 12);
+        }
+        for (const auto& v : e.vertices)
+        {
+            const Vec3f n = ToGltfAxes(v.normal);
+            bin.Put(&n, 12);
+        }
+        for (const auto& v : e.vertices)
+            bin.Put(&v.texCoord, 8);
+
+        for (size_t mi = 0; mi < e.meshes.size(); mi++)
+        {
+            if (e.indexOffsets[mi] == std::numeric_limits<size_t>::max())
+                continue;
+            const auto indices = geometry.Indices(e.meshes[mi]);
+            const size_t count = indices.size() / 3 * 3;
+            for (size_t i = 0; i < count; i += 3)
+            {
+                // Studio triangles are clockwise; glTF front faces are counter-clockwise.
+                const uint32_t tri[3] = {indices[i], indices[i + 2], indices[i + 1]};
+                if (e.shortIndices)
+                {
+                    const uint16_t shortTri[3] = {static_cast<uint16_t>(tri[0]), static_cast<uint16_t>(tri[1]), static_cast<uint16_t>(tri[2])};
+                    bin.Put(shortTri, sizeof(shortTri));
+                }
+                else
+                {
+                    bin.Put(tri, sizeof(tri));
+                }
+            }
+            bin.PadTo4(count * (e.shortIndices ? 2 : 4));
+        }
+    }
+    for (const auto& image : images)
+    {
+        bin.Put(image.png.data(), image.png.size());
+        bin.PadTo4(image.png.size());
+    }
+    bin.Flush();
+    return static_cast<bool>(out);
+}
+
+bool WriteGlb(const std::filesystem::path& filePath, const StudioModelCpu& model, const GlbExportOptions& options, Profiler* profiler)
+{
+    std::ofstream out(filePath, std::ios::binary);
+    if (!out)
+        return false;
+    return WriteGlb(out, model, options, profiler);
+}
@@ -4,14 +4,14 @@
 #include <array>
 #include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <string>
 
-#ifdef _WIN32
-#include <wincodec.h>
-#include <wrl/client.h>
-
-using Microsoft::WRL::ComPtr;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 namespace
@@ -22,139 +22,222 @@ std::string ToLower(std::string s)
     return s;
 }
 
-#ifdef _WIN32
-bool WritePngWic(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba)
+// True-colour (type 2) or run-length true-colour (type 10), 32 bpp, 8 alpha bits,
+// top-left origin.
+std::array<uint8_t, 18> MakeTgaHeader(int width, int height, TgaCompression compression)
 {
-    if (width <= 0 || height <= 0)
-        return false;
-    if (rgba.size() != static_cast<size_t>(width) * static_cast<size_t>(height) * 4)
-        return false;
+    std::array<uint8_t, 18> header{};
+    header[2] = compression == TgaCompression::Rle ? 10 : 2;
+    header[12] = static_cast<uint8_t>(width & 0xff);
+    header[13] = static_cast<uint8_t>((width >> 8) & 0xff);
+    header[14] = static_cast<uint8_t>(height & 0xff);
+    header[15] = static_cast<uint8_t>((height >> 8) & 0xff);
+    header[16] = 32;
+    header[17] = 0x20 | 8;
+    return header;
+}
 
-    std::vector<uint8_t> bgra(rgba.size());
-    for (size_t i = 0; i + 3 < rgba.size(); i += 4)
+// RGBA -> BGRA: 4 pixels per step with SSE2, 16 with NEON, then a scalar tail.
+void SwizzleRgbaToBgra(const uint8_t* src, uint8_t* dst, size_t pixels)
+{
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    const __m128i keep = _mm_set1_epi32(static_cast<int>(0xff00ff00u));
+    const __m128i low = _mm_set1_epi32(0xff);
+    for (; i + 4 <= pixels; i += 4)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i r = _mm_and_si128(p, low);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+        const __m128i q = _mm_or_si128(_mm_and_si128(p, keep), _mm_or_si128(_mm_slli_epi32(r, 16), b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), q);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= pixels; i += 16)
+    {
+        uint8x16x4_t p = vld4q_u8(src + i * 4);
+        const uint8x16_t r = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = r;
+        vst4q_u8(dst + i * 4, p);
+    }
+#endif
+    for (; i < pixels; i++)
     {
-        bgra[i + 0] = rgba[i + 2];
-        bgra[i + 1] = rgba[i + 1];
-        bgra[i + 2] = rgba[i + 0];
-        bgra[i + 3] = rgba[i + 3];
+        dst[i * 4 + 0] = src[i * 4 + 2];
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = src[i * 4 + 0];
+        dst[i * 4 + 3] = src[i * 4 + 3];
     }
+}
 
-    ComPtr<IWICImagingFactory> factory;
-    HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(factory.GetAddressOf()));
-    if (FAILED(hr))
-        return false;
+// Packets never cross a scanline. Runs of two or more equal pixels become run packets,
+// everything else goes into raw packets of up to 128 pixels.
+void AppendRleRow(const uint8_t* bgra, size_t width, std::vector<uint8_t>& out)
+{
+    auto pixelAt = [&](size_t x) {
+        uint32_t p;
+        std::memcpy(&p, bgra + x * 4, 4);
+        return p;
+    };
+
+    size_t x = 0;
+    while (x < width)
+    {
+        const uint32_t p = pixelAt(x);
+        size_t run = 1;
+        while (x + run < width && run < 128 && pixelAt(x + run) == p)
+            run++;
+        if (run >= 2)
+        {
+            out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+            out.insert(out.end(), bgra + x * 4, bgra + x * 4 + 4);
+            x += run;
+            continue;
+        }
 
-    ComPtr<IWICBitmapEncoder> encoder;
-    hr = factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, encoder.GetAddressOf());
-    if (FAILED(hr))
-        return false;
+        size_t raw = 1;
+        while (x + raw < width && raw < 128 && !(x + raw + 1 < width && pixelAt(x + raw) == pixelAt(x + raw + 1)))
+            raw++;
+        out.push_back(static_cast<uint8_t>(raw - 1));
+        out.insert(out.end(), bgra + x * 4, bgra + (x + raw) * 4);
+        x += raw;
+    }
+}
 
-    ComPtr<IWICStream> stream;
-    hr = factory->CreateStream(stream.GetAddressOf());
-    if (FAILED(hr))
-        return false;
+// Converts `rows` scanlines into file bytes in `out` (replacing its contents).
+void EncodeTgaRows(const uint8_t* rgba, int width, int rows, TgaCompression compression, std::vector<uint8_t>& out, std::vector<uint8_t>& scratch)
+{
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const size_t bytes = rowBytes * static_cast<size_t>(rows);
+    if (compression != TgaCompression::Rle)
+    {
+        out.resize(bytes);
+        SwizzleRgbaToBgra(rgba, out.data(), bytes / 4);
+        return;
+    }
 
-    hr = stream->InitializeFromFilename(filePath.c_str(), GENERIC_WRITE);
-    if (FAILED(hr))
-        return false;
+    out.clear();
+    scratch.resize(rowBytes);
+    for (int y = 0; y < rows; y++)
+    {
+        SwizzleRgbaToBgra(rgba + static_cast<size_t>(y) * rowBytes, scratch.data(), static_cast<size_t>(width));
+        AppendRleRow(scratch.data(), static_cast<size_t>(width), out);
+    }
+}
 
-    hr = encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache);
-    if (FAILED(hr))
-        return false;
+// Rows per EncodeTgaRows call so each stream write is about a megabyte.
+int RowsPerChunk(int width)
+{
+    return std::max(1, static_cast<int>((size_t{1} << 20) / (static_cast<size_t>(width) * 4)));
+}
+} // namespace
 
-    ComPtr<IWICBitmapFrameEncode> frame;
-    ComPtr<IPropertyBag2> props;
-    hr = encoder->CreateNewFrame(frame.GetAddressOf(), props.GetAddressOf());
-    if (FAILED(hr))
+bool TgaStreamWriter::Open(const std::filesystem::path& filePath, int width, int height, TgaCompression compression, Profiler* profiler)
+{
+    if (width <= 0 || height <= 0 || width > kMaxTgaDimension || height > kMaxTgaDimension)
         return false;
 
-    hr = frame->Initialize(props.Get());
-    if (FAILED(hr))
+    out_.open(filePath, std::ios::binary);
+    if (!out_)
         return false;
+    width_ = width;
+    height_ = height;
+    rowsWritten_ = 0;
+    compression_ = compression;
+    memory_.Reset(profiler, MemoryTag::Encoder, CapacityBytes(encoded_) + CapacityBytes(scratch_));
 
-    hr = frame->SetSize(static_cast<UINT>(width), static_cast<UINT>(height));
-    if (FAILED(hr))
-        return false;
+    const auto header = MakeTgaHeader(width, height, compression);
+    out_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    return static_cast<bool>(out_);
+}
 
-    WICPixelFormatGUID format = GUID_WICPixelFormat32bppBGRA;
-    hr = frame->SetPixelFormat(&format);
-    if (FAILED(hr))
+bool TgaStreamWriter::WriteRows(const uint8_t* rgba, int rows)
+{
+    if (!out_.is_open() || rows < 0 || rows > height_ - rowsWritten_)
         return false;
 
-    const UINT stride = static_cast<UINT>(width) * 4;
-    const UINT imageSize = stride * static_cast<UINT>(height);
-
-    hr = frame->WritePixels(static_cast<UINT>(height), stride, imageSize, const_cast<BYTE*>(bgra.data()));
-    if (FAILED(hr))
-        return false;
+    const int chunkRows = RowsPerChunk(width_);
+    for (int y = 0; y < rows && out_; y += chunkRows)
+    {
+        const int n = std::min(chunkRows, rows - y);
+        EncodeTgaRows(rgba + static_cast<size_t>(y) * static_cast<size_t>(width_) * 4, width_, n, compression_, encoded_, scratch_);
+        out_.write(reinterpret_cast<const char*>(encoded_.data()), static_cast<std::streamsize>(encoded_.size()));
+    }
+    memory_.Set(CapacityBytes(encoded_) + CapacityBytes(scratch_));
+    rowsWritten_ += rows;
+    return static_cast<bool>(out_);
+}
 
-    hr = frame->Commit();
-    if (FAILED(hr))
+bool TgaStreamWriter::Close()
+{
+    if (!out_.is_open())
         return false;
+    const bool complete = rowsWritten_ == height_ && static_cast<bool>(out_);
+    out_.close();
+    return complete && static_cast<bool>(out_);
+}
 
-    hr = encoder->Commit();
-    if (FAILED(hr))
+bool WriteTgaRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, TgaCompression compression, Profiler* profiler)
+{
+    if (rgba.size() != static_cast<size_t>(std::max(width, 0)) * static_cast<size_t>(std::max(height, 0)) * 4)
         return false;
 
-    return true;
+    TgaStreamWriter writer;
+    return writer.Open(filePath, width, height, compression, profiler) && writer.WriteRows(rgba.data(), height) && writer.Close();
 }
-#endif
-} // namespace
 
-bool WriteTgaRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba)
+bool EncodeTgaRgba(int width, int height, const std::vector<uint8_t>& rgba, TgaCompression compression, std::vector<uint8_t>& out, Profiler* profiler)
 {
-    if (width <= 0 || height <= 0)
+    if (width <= 0 || height <= 0 || width > kMaxTgaDimension || height > kMaxTgaDimension)
         return false;
     if (rgba.size() != static_cast<size_t>(width) * static_cast<size_t>(height) * 4)
         return false;
 
-    std::ofstream out(filePath, std::ios::binary);
-    if (!out)
-        return false;
-
-    std::array<uint8_t, 18> header{};
-    header[2] = 2;
-    header[12] = static_cast<uint8_t>(width & 0xff);
-    header[13] = static_cast<uint8_t>((width >> 8) & 0xff);
-    header[14] = static_cast<uint8_t>(height & 0xff);
-    header[15] = static_cast<uint8_t>((height >> 8) & 0xff);
-    header[16] = 32;
-    header[17] = 0x20 | 8;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> scratch;
+    EncodeTgaRows(rgba.data(), width, height, compression, pixels, scratch);
 
-    out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
-    if (!out)
-        return false;
-
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < width; x++)
-        {
-            const size_t idx = (static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)) * 4;
-            const uint8_t r = rgba[idx + 0];
-            const uint8_t g = rgba[idx + 1];
-            const uint8_t b = rgba[idx + 2];
-            const uint8_t a = rgba[idx + 3];
-            const uint8_t bgra[4] = {b, g, r, a};
-            out.write(reinterpret_cast<const char*>(bgra), 4);
-        }
-    }
-
-    return static_cast<bool>(out);
+    const auto header = MakeTgaHeader(width, height, compression);
+    out.clear();
+    out.reserve(header.size() + pixels.size());
+    const TrackedMemory workingSet(profiler, MemoryTag::Encoder, CapacityBytes(pixels) + CapacityBytes(scratch) + CapacityBytes(out));
+    out.insert(out.end(), header.begin(), header.end());
+    out.insert(out.end(), pixels.begin(), pixels.end());
+    return true;
 }
 
-bool WriteImageAuto(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba)
+ImageFormat ImageFormatFromPath(const std::filesystem::path& filePath)
 {
     const auto ext = ToLower(filePath.extension().string());
-    if (ext == ".tga")
-        return WriteTgaRgba(filePath, width, height, rgba);
-
-#ifdef _WIN32
-    if (ext == ".png")
-        return WritePngWic(filePath, width, height, rgba);
-#else
     if (ext == ".png")
-        return false;
-#endif
+        return ImageFormat::Png;
+    if (ext == ".qoi")
+        return ImageFormat::Qoi;
+    return ImageFormat::Tga;
+}
+
+bool EncodeImage(ImageFormat format, int width, int height, const std::vector<uint8_t>& rgba, const ImageWriteOptions& options, std::vector<uint8_t>& out, Profiler* profiler)
+{
+    ScopedTrace trace(profiler, "EncodeImage");
+    if (format == ImageFormat::Png)
+        return EncodePngRgba(width, height, rgba, options.pngCompression, out, profiler);
+    if (format == ImageFormat::Qoi)
+        return EncodeQoiRgba(width, height, rgba, out, profiler);
+    return EncodeTgaRgba(width, height, rgba, options.tgaCompression, out, profiler);
+}
 
-    return WriteTgaRgba(filePath, width, height, rgba);
+bool WriteImage(const std::filesystem::path& filePath, ImageFormat format, int width, int height, const std::vector<uint8_t>& rgba, const ImageWriteOptions& options, Profiler* profiler)
+{
+    ScopedTrace trace(profiler, "WriteImage", filePath.u8string());
+    if (format == ImageFormat::Png)
+        return WritePngRgba(filePath, width, height, rgba, options.pngCompression, profiler);
+    if (format == ImageFormat::Qoi)
+        return WriteQoiRgba(filePath, width, height, rgba, profiler);
+    return WriteTgaRgba(filePath, width, height, rgba, options.tgaCompression, profiler);
+}
+
+bool WriteImageAuto(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, const ImageWriteOptions& options, Profiler* profiler)
+{
+    return WriteImage(filePath, ImageFormatFromPath(filePath), width, height, rgba, options, profiler);
 }
@@ -1,20 +1,28 @@
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <string>
 #include <vector>
 
-#ifdef _WIN32
-#include <Windows.h>
-#include <objbase.h>
-#endif
-
+#include "CrossPlatformMdlExporter/atlas.hpp"
+#include "CrossPlatformMdlExporter/gltf_exporter.hpp"
 #include "CrossPlatformMdlExporter/image_writer.hpp"
 #include "CrossPlatformMdlExporter/mdl_model.hpp"
+#include "CrossPlatformMdlExporter/mesh_optimizer.hpp"
 #include "CrossPlatformMdlExporter/rasterizer.hpp"
+#include "CrossPlatformMdlExporter/resample.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 namespace
 {
@@ -41,6 +49,23 @@ bool TryParseInt(const std::string& s, int& out)
     }
 }
 
+bool TryParseFloat(const std::string& s, float& out)
+{
+    try
+    {
+        size_t pos = 0;
+        const float v = std::stof(s, &pos);
+        if (pos != s.size() || !std::isfinite(v))
+            return false;
+        out = v;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
 BackgroundPreset ParseBackgroundPreset(const std::string& s)
 {
     const auto v = ToLower(s);
@@ -52,29 +77,170 @@ BackgroundPreset ParseBackgroundPreset(const std::string& s)
         return BackgroundPreset::Transparent;
     return BackgroundPreset::Blue;
 }
-} // namespace
 
-int main(int argc, char** argv)
+bool TryParseTextureFilter(const std::string& s, TextureFilter& out)
+{
+    const auto v = ToLower(s);
+    if (v == "bilinear" || v == "0")
+        out = TextureFilter::Bilinear;
+    else if (v == "nearest-mip" || v == "mip" || v == "1")
+        out = TextureFilter::NearestMip;
+    else if (v == "trilinear" || v == "2")
+        out = TextureFilter::Trilinear;
+    else
+        return false;
+    return true;
+}
+
+bool TryParseShadingMode(const std::string& s, ShadingMode& out)
+{
+    const auto v = ToLower(s);
+    if (v == "forward" || v == "0")
+        out = ShadingMode::Forward;
+    else if (v == "visibility" || v == "deferred" || v == "1")
+        out = ShadingMode::Visibility;
+    else
+        return false;
+    return true;
+}
+
+struct OutputSize
+{
+    int width{};
+    int height{};
+};
+
+// "64,128,256" or "64x48,128x96". A bare number is a width; its height keeps the
+// --width/--height aspect ratio.
+bool TryParseSizeList(const std::string& s, int aspectWidth, int aspectHeight, std::vector<OutputSize>& out)
+{
+    out.clear();
+    size_t start = 0;
+    while (start <= s.size())
+    {
+        const size_t end = std::min(s.find(',', start), s.size());
+        const std::string item = ToLower(s.substr(start, end - start));
+        const size_t x = item.find('x');
+
+        OutputSize size{};
+        if (x == std::string::npos)
+        {
+            if (!TryParseInt(item, size.width) || size.width <= 0)
+                return false;
+            size.height = std::max(1, static_cast<int>(std::lround(static_cast<double>(size.width) * aspectHeight / std::max(1, aspectWidth))));
+        }
+        else if (!TryParseInt(item.substr(0, x), size.width) || !TryParseInt(item.substr(x + 1), size.height) || size.width <= 0 || size.height <= 0)
+        {
+            return false;
+        }
+
+        out.push_back(size);
+        start = end + 1;
+    }
+    return !out.empty();
+}
+
+// Every size is the largest one scaled down uniformly, give or take the rounding of a bare
+// width's height; anything else would need cropping or a distorted downscale.
+bool FitsLargestSize(const OutputSize& size, const OutputSize& largest)
+{
+    const int64_t skew = static_cast<int64_t>(size.height) * largest.width - static_cast<int64_t>(size.width) * largest.height;
+    return size.width <= largest.width && size.height <= largest.height && std::abs(skew) <= largest.width;
+}
+
+std::filesystem::path AddSizeSuffix(const std::filesystem::path& filePath, int width, int height)
+{
+    const auto name = filePath.stem().string() + "_" + std::to_string(width) + "x" + std::to_string(height) + filePath.extension().string();
+    return filePath.parent_path() / name;
+}
+
+bool TryParseTextureLayout(const std::string& s, TextureLayout& out)
+{
+    const auto v = ToLower(s);
+    if (v == "linear" || v == "0")
+        out = TextureLayout::RowMajor;
+    else if (v == "tiled" || v == "1")
+        out = TextureLayout::Tiled4x4;
+    else
+        return false;
+    return true;
+}
+
+bool TryParsePngCompression(const std::string& s, PngCompression& out)
+{
+    const auto v = ToLower(s);
+    if (v == "stored" || v == "0")
+        out = PngCompression::Stored;
+    else if (v == "fast" || v == "1")
+        out = PngCompression::Fast;
+    else if (v == "best" || v == "2")
+        out = PngCompression::Best;
+    else
+        return false;
+    return true;
+}
+
+bool TryParseImageFormat(const std::string& s, ImageFormat& out)
+{
+    const auto v = ToLower(s);
+    if (v == "tga")
+        out = ImageFormat::Tga;
+    else if (v == "png")
+        out = ImageFormat::Png;
+    else if (v == "qoi")
+        out = ImageFormat::Qoi;
+    else
+        return false;
+    return true;
+}
+
+void SetStdoutBinary()
 {
 #ifdef _WIN32
-    HRESULT coInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    _setmode(_fileno(stdout), _O_BINARY);
 #endif
+}
+
+bool WriteToStdout(const std::vector<uint8_t>& bytes)
+{
+    SetStdoutBinary();
+    return std::fwrite(bytes.data(), 1, bytes.size(), stdout) == bytes.size() && std::fflush(stdout) == 0;
+}
+} // namespace
 
+int main(int argc, char** argv)
+{
     if (argc < 3)
     {
-        std::cerr << "Usage: CrossPlatformMdlExporter <input.mdl> <output.(png|tga)> [--width N] [--height N] [--background blue|green|transparent]\n";
-#ifdef _WIN32
-        if (SUCCEEDED(coInit))
-            CoUninitialize();
-#endif
+        std::cerr << "Usage: CrossPlatformMdlExporter <input.mdl> <output.(png|tga|qoi|glb)|-> [--format tga|png|qoi|glb] [--glb-all-submodels] [--width N] [--height N] [--background blue|green|transparent] [--filter bilinear|nearest-mip|trilinear] [--texture-layout linear|tiled] [--optimize-vertex-cache] [--shading forward|visibility] [--quality full|draft] [--lighting] [--yaw DEG] [--views N] [--columns N] [--sizes N[,N...]] [--band-rows N] [--png-level stored|fast|best] [--tga-rle] [--atlas [--atlas-model FILE]... [--atlas-padding N] [--atlas-json FILE] [--atlas-uvs]] [--profile] [--profile-json FILE] [--trace FILE]\n";
         return 2;
     }
 
     const std::filesystem::path inputPath = std::filesystem::u8path(argv[1]);
     const std::filesystem::path outputPath = std::filesystem::u8path(argv[2]);
+    // "-" writes the encoded image to stdout; all diagnostics already go to stderr.
+    const bool toStdout = std::string(argv[2]) == "-";
+    ImageFormat outputFormat = ImageFormatFromPath(outputPath);
+    // .glb exports geometry and textures instead of rendering.
+    bool glbOutput = ToLower(outputPath.extension().string()) == ".glb";
+    GlbExportOptions glbOptions{};
 
     RenderOptions options{};
+    LoadOptions loadOptions{};
+    ImageWriteOptions writeOptions{};
     bool verbose = false;
+    int views = 1;
+    int columns = 0;
+    std::string sizesArg;
+    int bandRows = 0;
+    bool profile = false;
+    std::filesystem::path profileJsonPath;
+    std::filesystem::path tracePath;
+    bool atlas = false;
+    bool atlasUvs = false;
+    AtlasOptions atlasOptions{};
+    std::vector<std::filesystem::path> atlasModelPaths;
+    std::filesystem::path atlasJsonPath;
 
     for (int i = 3; i < argc; i++)
     {
@@ -84,6 +250,63 @@ int main(int argc, char** argv)
             verbose = true;
             continue;
         }
+        if (arg == "--yaw" && i + 1 < argc)
+        {
+            if (!TryParseFloat(argv[++i], options.yawDegrees))
+            {
+                std::cerr << "Invalid --yaw: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--sizes" && i + 1 < argc)
+        {
+            sizesArg = argv[++i];
+            continue;
+        }
+        if (arg == "--band-rows" && i + 1 < argc)
+        {
+            if (!TryParseInt(argv[++i], bandRows) || bandRows < 0)
+            {
+                std::cerr << "Invalid --band-rows: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--views" && i + 1 < argc)
+        {
+            int v = 0;
+            if (TryParseInt(argv[++i], v))
+                views = v;
+            continue;
+        }
+        if (arg == "--columns" && i + 1 < argc)
+        {
+            int v = 0;
+            if (TryParseInt(argv[++i], v))
+                columns = v;
+            continue;
+        }
+        if (arg == "--profile")
+        {
+            profile = true;
+            continue;
+        }
+        if (arg == "--profile-json" && i + 1 < argc)
+        {
+            profileJsonPath = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            tracePath = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        if (arg == "--lighting")
+        {
+            options.lighting = true;
+            continue;
+        }
         if (arg == "--width" && i + 1 < argc)
         {
             int v = 0;
@@ -103,58 +326,219 @@ int main(int argc, char** argv)
             options.background = ParseBackgroundPreset(argv[++i]);
             continue;
         }
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            if (!TryParseTextureFilter(argv[++i], options.textureFilter))
+            {
+                std::cerr << "Invalid --filter: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--shading" && i + 1 < argc)
+        {
+            if (!TryParseShadingMode(argv[++i], options.shadingMode))
+            {
+                std::cerr << "Invalid --shading: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--quality" && i + 1 < argc)
+        {
+            const auto v = ToLower(argv[++i]);
+            if (v != "full" && v != "draft")
+            {
+                std::cerr << "Invalid --quality: " << argv[i] << "\n";
+                return 2;
+            }
+            options.quality = v == "draft" ? RenderQuality::Draft : RenderQuality::Full;
+            loadOptions.skipTextures = options.quality == RenderQuality::Draft;
+            continue;
+        }
+        if (arg == "--png-level" && i + 1 < argc)
+        {
+            if (!TryParsePngCompression(argv[++i], writeOptions.pngCompression))
+            {
+                std::cerr << "Invalid --png-level: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--format" && i + 1 < argc)
+        {
+            glbOutput = ToLower(argv[++i]) == "glb";
+            if (!glbOutput && !TryParseImageFormat(argv[i], outputFormat))
+            {
+                std::cerr << "Invalid --format: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--optimize-vertex-cache")
+        {
+            loadOptions.optimizeVertexCache = true;
+            continue;
+        }
+        if (arg == "--glb-all-submodels")
+        {
+            glbOptions.allSubmodels = true;
+            continue;
+        }
+        if (arg == "--atlas")
+        {
+            atlas = true;
+            continue;
+        }
+        if (arg == "--atlas-model" && i + 1 < argc)
+        {
+            atlasModelPaths.push_back(std::filesystem::u8path(argv[++i]));
+            continue;
+        }
+        if (arg == "--atlas-padding" && i + 1 < argc)
+        {
+            int v = 0;
+            if (TryParseInt(argv[++i], v))
+                atlasOptions.padding = std::max(0, v);
+            continue;
+        }
+        if (arg == "--atlas-json" && i + 1 < argc)
+        {
+            atlasJsonPath = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        if (arg == "--atlas-uvs")
+        {
+            atlasUvs = true;
+            continue;
+        }
+        if (arg == "--tga-rle")
+        {
+            writeOptions.tgaCompression = TgaCompression::Rle;
+            continue;
+        }
+        if (arg == "--texture-layout" && i + 1 < argc)
+        {
+            if (!TryParseTextureLayout(argv[++i], loadOptions.textureLayout))
+            {
+                std::cerr << "Invalid --texture-layout: " << argv[i] << "\n";
+                return 2;
+            }
+            continue;
+        }
     }
 
+    // Multi-resolution output renders once at the largest size and downscales the rest.
+    std::vector<OutputSize> sizes;
+    if (!sizesArg.empty())
+    {
+        if (!TryParseSizeList(sizesArg, options.width, options.height, sizes))
+        {
+            std::cerr << "Invalid --sizes: " << sizesArg << "\n";
+            return 2;
+        }
+        const auto largest = std::max_element(sizes.begin(), sizes.end(), [](const OutputSize& a, const OutputSize& b) {
+            return static_cast<int64_t>(a.width) * a.height < static_cast<int64_t>(b.width) * b.height;
+        });
+        for (const auto& size : sizes)
+        {
+            if (!FitsLargestSize(size, *largest))
+            {
+                std::cerr << "Invalid --sizes: " << size.width << "x" << size.height << " does not keep the aspect ratio of " << largest->width << "x" << largest->height << "\n";
+                return 2;
+            }
+        }
+        options.width = largest->width;
+        options.height = largest->height;
+    }
+    if (toStdout && sizes.size() > 1)
+    {
+        std::cerr << "--sizes with more than one size cannot write to stdout\n";
+        return 2;
+    }
+    if (bandRows > 0 && (views > 1 || !sizes.empty()))
+    {
+        std::cerr << "--band-rows cannot be combined with " << (views > 1 ? "--views" : "--sizes") << "\n";
+        return 2;
+    }
+    // Draft loads no textures, so there is nothing to export or pack.
+    if (options.quality == RenderQuality::Draft && (glbOutput || atlas))
+    {
+        std::cerr << "--quality draft only applies to rendered images, not to " << (glbOutput ? ".glb export" : "--atlas") << "\n";
+        return 2;
+    }
+
+    // --verbose only needs the memory accounting, but that is cheap enough to collect the
+    // timings along with it.
+    Profiler profiler;
+    Profiler* const activeProfiler = (profile || verbose || !profileJsonPath.empty() || !tracePath.empty()) ? &profiler : nullptr;
+    if (!tracePath.empty())
+        profiler.EnableTrace();
+    auto writeProfile = [&]() {
+        if (profile)
+            WriteProfileTable(std::cerr, profiler);
+        else if (verbose)
+            WriteMemoryTable(std::cerr, profiler);
+        if (!profileJsonPath.empty())
+        {
+            std::ofstream json(profileJsonPath);
+            WriteProfileJson(json, profiler);
+            if (!json)
+                std::cerr << "Write profile failed: " << profileJsonPath.string() << "\n";
+        }
+        if (!tracePath.empty())
+        {
+            std::ofstream trace(tracePath);
+            WriteTraceJson(trace, profiler);
+            if (!trace)
+                std::cerr << "Write trace failed: " << tracePath.string() << "\n";
+        }
+    };
+
     StudioModelCpu model;
-    if (!model.LoadFromFile(inputPath))
+    if (!model.LoadFromFile(inputPath, loadOptions, activeProfiler))
     {
         std::cerr << "Failed to load mdl: " << inputPath.string() << "\n";
-#ifdef _WIN32
-        if (SUCCEEDED(coInit))
-            CoUninitialize();
-#endif
         return 1;
     }
 
     if (verbose)
     {
-        size_t bodyParts = model.GetBodyParts().size();
-        size_t models = 0;
-        size_t meshes = 0;
-        size_t vertices = 0;
-        size_t indices = 0;
+        const ModelGeometry& geometry = model.GetGeometry();
         Vec3f minP{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
         Vec3f maxP{-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
-        for (const auto& bp : model.GetBodyParts())
+        for (const auto& v : geometry.vertices)
         {
-            models += bp.models.size();
-            for (const auto& m : bp.models)
-            {
-                vertices += m.vertices.size();
-                meshes += m.meshes.size();
-                for (const auto& v : m.vertices)
-                {
-                    minP.x = std::min(minP.x, v.position.x);
-                    minP.y = std::min(minP.y, v.position.y);
-                    minP.z = std::min(minP.z, v.position.z);
-                    maxP.x = std::max(maxP.x, v.position.x);
-                    maxP.y = std::max(maxP.y, v.position.y);
-                    maxP.z = std::max(maxP.z, v.position.z);
-                }
-                for (const auto& me : m.meshes)
-                {
-                    indices += me.indices.size();
-                    std::cerr << "Mesh texId=" << me.textureId << " indices=" << me.indices.size() << "\n";
-                }
-            }
+            minP.x = std::min(minP.x, v.position.x);
+            minP.y = std::min(minP.y, v.position.y);
+            minP.z = std::min(minP.z, v.position.z);
+            maxP.x = std::max(maxP.x, v.position.x);
+            maxP.y = std::max(maxP.y, v.position.y);
+            maxP.z = std::max(maxP.z, v.position.z);
         }
-        std::cerr << "BodyParts=" << bodyParts << " Models=" << models << " Meshes=" << meshes << " Vertices=" << vertices << " Indices=" << indices << " Textures=" << model.GetTextures().size()
+        for (const auto& me : geometry.meshes)
+            std::cerr << "Mesh texId=" << me.textureId << " indices=" << me.indexCount << "\n";
+        std::cerr << "BodyParts=" << geometry.bodyParts.size() << " Models=" << geometry.models.size() << " Meshes=" << geometry.meshes.size() << " Vertices=" << geometry.vertices.size()
+                  << " Indices=" << geometry.indices.size() << " Textures=" << model.GetTextures().size()
                   << " PosMin=(" << minP.x << "," << minP.y << "," << minP.z << ")"
                   << " PosMax=(" << maxP.x << "," << maxP.y << "," << maxP.z << ")"
                   << " HdrMin=(" << model.GetBoundsMin().x << "," << model.GetBoundsMin().y << "," << model.GetBoundsMin().z << ")"
                   << " HdrMax=(" << model.GetBoundsMax().x << "," << model.GetBoundsMax().y << "," << model.GetBoundsMax().z << ")"
                   << "\n";
 
+        uint64_t triangles = 0;
+        uint64_t misses = 0;
+        for (const auto& me : geometry.meshes)
+        {
+            triangles += me.indexCount / 3;
+            misses += CountVertexCacheMisses(geometry.Indices(me));
+        }
+        const auto& cacheStats = model.GetVertexCacheStats();
+        std::cerr << "VertexCache FIFO" << kVertexCacheSize << " ACMR=" << (triangles > 0 ? static_cast<double>(misses) / static_cast<double>(triangles) : 0.0);
+        if (cacheStats.triangles > 0)
+            std::cerr << " (before optimization " << static_cast<double>(cacheStats.missesBefore) / static_cast<double>(cacheStats.triangles) << ")";
+        std::cerr << "\n";
+
         for (size_t ti = 0; ti < model.GetTextures().size(); ti++)
         {
             const auto& tex = model.GetTextures()[ti];
@@ -164,40 +548,209 @@ int main(int argc, char** argv)
                 if (tex.rgba[p] != 0)
                     nonZeroAlpha++;
             }
-            std::cerr << "Texture[" << ti << "] " << tex.width << "x" << tex.height << " alphaNonZero=" << nonZeroAlpha << "/" << (tex.rgba.size() / 4) << "\n";
+            std::cerr << "Texture[" << ti << "] " << tex.width << "x" << tex.height << " alphaNonZero=" << nonZeroAlpha << "/" << (static_cast<size_t>(tex.width) * static_cast<size_t>(tex.height)) << "\n";
         }
     }
 
+    if (glbOutput)
+    {
+        glbOptions.textureCompression = writeOptions.pngCompression;
+        bool written = false;
+        {
+            ScopedProfile encodeProfile(activeProfiler, ProfileStage::Encode);
+            if (toStdout)
+            {
+                SetStdoutBinary();
+                written = WriteGlb(std::cout, model, glbOptions, activeProfiler) && std::cout.flush();
+            }
+            else
+            {
+                written = WriteGlb(outputPath, model, glbOptions, activeProfiler);
+            }
+        }
+        if (!written)
+        {
+            std::cerr << "Write glb failed: " << (toStdout ? std::string("<stdout>") : outputPath.string()) << "\n";
+            return 1;
+        }
+        writeProfile();
+        return 0;
+    }
+
+    // Atlas export packs the skins of this model (and any --atlas-model) into one image plus a
+    // JSON sidecar, instead of rendering.
+    if (atlas)
+    {
+        std::vector<StudioModelCpu> extraModels(atlasModelPaths.size());
+        std::vector<const StudioModelCpu*> sources{&model};
+        for (size_t i = 0; i < atlasModelPaths.size(); i++)
+        {
+            if (!extraModels[i].LoadFromFile(atlasModelPaths[i], loadOptions, activeProfiler))
+            {
+                std::cerr << "Failed to load mdl: " << atlasModelPaths[i].string() << "\n";
+                return 1;
+            }
+            sources.push_back(&extraModels[i]);
+        }
+
+        TextureAtlas textureAtlas;
+        if (!BuildTextureAtlas(sources, atlasOptions, textureAtlas))
+        {
+            std::cerr << "Atlas packing failed (no textures, or a texture wider than " << atlasOptions.maxWidth << ")\n";
+            return 1;
+        }
+        const TrackedMemory atlasMemory(activeProfiler, MemoryTag::Textures, CapacityBytes(textureAtlas.rgba));
+        if (verbose)
+            std::cerr << "Atlas " << textureAtlas.width << "x" << textureAtlas.height << " textures=" << textureAtlas.rects.size() << "\n";
+
+        {
+            ScopedProfile encodeProfile(activeProfiler, ProfileStage::Encode, static_cast<uint64_t>(textureAtlas.width) * static_cast<uint64_t>(textureAtlas.height));
+            std::vector<uint8_t> encoded;
+            const bool written = toStdout ? EncodeImage(outputFormat, textureAtlas.width, textureAtlas.height, textureAtlas.rgba, writeOptions, encoded, activeProfiler) && WriteToStdout(encoded)
+                                          : WriteImage(outputPath, outputFormat, textureAtlas.width, textureAtlas.height, textureAtlas.rgba, writeOptions, activeProfiler);
+            if (!written)
+            {
+                std::cerr << "Write image failed: " << (toStdout ? std::string("<stdout>") : outputPath.string()) << "\n";
+                return 1;
+            }
+        }
+
+        if (atlasJsonPath.empty() && !toStdout)
+            atlasJsonPath = std::filesystem::path(outputPath).replace_extension(".json");
+        if (!atlasJsonPath.empty())
+        {
+            std::ofstream json(atlasJsonPath);
+            WriteAtlasJson(json, textureAtlas, sources);
+            if (!json)
+            {
+                std::cerr << "Write atlas json failed: " << atlasJsonPath.string() << "\n";
+                return 1;
+            }
+        }
+
+        // Remapped texture coordinates as little-endian float32 pairs, one per triangle
+        // corner, in source / body part / model / mesh / index order.
+        if (atlasUvs && !atlasJsonPath.empty())
+        {
+            const auto uvPath = std::filesystem::path(atlasJsonPath).replace_extension(".uv");
+            std::ofstream uvOut(uvPath, std::ios::binary);
+            for (size_t source = 0; source < sources.size(); source++)
+            {
+                auto geometry = sources[source]->GetGeometry();
+                if (!RemapTexCoordsToAtlas(textureAtlas, static_cast<int>(source), geometry))
+                    std::cerr << "Warning: " << sources[source]->GetFilePath().string() << " has texture coordinates outside [0, 1]; they won't map into the atlas correctly\n";
+                for (const auto& m : geometry.models)
+                {
+                    const auto vertices = geometry.Vertices(m);
+                    for (const auto& mesh : geometry.Meshes(m))
+                    {
+                        for (const uint32_t index : geometry.Indices(mesh))
+                            uvOut.write(reinterpret_cast<const char*>(&vertices[index].texCoord), sizeof(Vec2f));
+                    }
+                }
+            }
+            if (!uvOut)
+            {
+                std::cerr << "Write atlas uvs failed: " << uvPath.string() << "\n";
+                return 1;
+            }
+        }
+
+        writeProfile();
+        return 0;
+    }
+
+    // Banded output streams each finished strip straight into the TGA file, so neither the
+    // full colour buffer nor the full depth buffer is ever allocated.
+    if (bandRows > 0)
+    {
+        if (outputFormat != ImageFormat::Tga || toStdout)
+        {
+            std::cerr << "--band-rows writes .tga files only\n";
+            return 2;
+        }
+
+        TgaStreamWriter writer;
+        RenderStats bandStats{};
+        RenderContext context;
+        bool streamed = writer.Open(outputPath, std::max(1, options.width), std::max(1, options.height), writeOptions.tgaCompression, activeProfiler);
+        if (streamed)
+        {
+            auto sink = [&](int, int rows, const uint8_t* band) {
+                ScopedProfile encodeProfile(activeProfiler, ProfileStage::Encode, static_cast<uint64_t>(rows) * static_cast<uint64_t>(context.GetWidth()));
+                return writer.WriteRows(band, rows);
+            };
+            streamed = context.RenderBanded(model, options, bandRows, sink, verbose ? &bandStats : nullptr, activeProfiler) && writer.Close();
+        }
+        if (!streamed)
+        {
+            std::cerr << "Banded render failed: " << outputPath.string() << "\n";
+            return 1;
+        }
+        if (verbose)
+            std::cerr << "Render triangles=" << bandStats.triangles << " degenerate=" << bandStats.degenerateTriangles << " pixelsShaded=" << bandStats.pixelsShaded << " pixelsWritten=" << bandStats.pixelsWritten << " bandRows=" << bandRows << "\n";
+        writeProfile();
+        return 0;
+    }
+
     std::vector<uint8_t> rgba;
     RenderStats renderStats{};
-    if (!RenderThumbnailRgba(model, options, rgba, verbose ? &renderStats : nullptr))
+    int imageWidth = options.width;
+    int imageHeight = options.height;
+    bool rendered = false;
+    if (views > 1)
+        rendered = RenderSpriteSheetRgba(model, options, MakeTurntableYaws(views), columns, rgba, imageWidth, imageHeight, verbose ? &renderStats : nullptr, activeProfiler);
+    else
+        rendered = RenderThumbnailRgba(model, options, rgba, verbose ? &renderStats : nullptr, activeProfiler);
+    if (!rendered)
     {
         std::cerr << "Render failed\n";
-#ifdef _WIN32
-        if (SUCCEEDED(coInit))
-            CoUninitialize();
-#endif
         return 1;
     }
+    const TrackedMemory imageMemory(activeProfiler, MemoryTag::RenderTargets, CapacityBytes(rgba));
 
     if (verbose)
     {
-        std::cerr << "Render triangles=" << renderStats.triangles << " degenerate=" << renderStats.degenerateTriangles << " pixelsWritten=" << renderStats.pixelsWritten << "\n";
+        std::cerr << "Render triangles=" << renderStats.triangles << " degenerate=" << renderStats.degenerateTriangles << " pixelsShaded=" << renderStats.pixelsShaded << " pixelsWritten=" << renderStats.pixelsWritten << "\n";
     }
 
-    if (!WriteImageAuto(outputPath, options.width, options.height, rgba))
+    if (sizes.empty())
+        sizes.push_back({options.width, options.height});
+
+    std::vector<uint8_t> scaled;
+    std::vector<uint8_t> encoded;
+    TrackedMemory outputMemory(activeProfiler, MemoryTag::Encoder);
+    for (const auto& size : sizes)
     {
-        std::cerr << "Write image failed: " << outputPath.string() << "\n";
-#ifdef _WIN32
-        if (SUCCEEDED(coInit))
-            CoUninitialize();
-#endif
-        return 1;
+        // With --views the sizes describe one cell; the whole sheet scales with it.
+        const int targetWidth = static_cast<int>(static_cast<int64_t>(imageWidth) * size.width / std::max(1, options.width));
+        const int targetHeight = static_cast<int>(static_cast<int64_t>(imageHeight) * size.height / std::max(1, options.height));
+        const auto path = sizesArg.empty() ? outputPath : AddSizeSuffix(outputPath, targetWidth, targetHeight);
+
+        ScopedProfile encodeProfile(activeProfiler, ProfileStage::Encode, static_cast<uint64_t>(targetWidth) * static_cast<uint64_t>(targetHeight));
+        const bool same = targetWidth == imageWidth && targetHeight == imageHeight;
+        if (!same && !DownscaleRgba(rgba, imageWidth, imageHeight, scaled, targetWidth, targetHeight))
+        {
+            std::cerr << "Downscale failed: " << targetWidth << "x" << targetHeight << "\n";
+            return 1;
+        }
+        const auto& pixels = same ? rgba : scaled;
+        outputMemory.Set(CapacityBytes(scaled));
+
+        bool written = false;
+        if (toStdout)
+            written = EncodeImage(outputFormat, targetWidth, targetHeight, pixels, writeOptions, encoded, activeProfiler) && WriteToStdout(encoded);
+        else
+            written = WriteImage(path, outputFormat, targetWidth, targetHeight, pixels, writeOptions, activeProfiler);
+        outputMemory.Set(CapacityBytes(scaled) + CapacityBytes(encoded));
+
+        if (!written)
+        {
+            std::cerr << "Write image failed: " << (toStdout ? std::string("<stdout>") : path.string()) << "\n";
+            return 1;
+        }
     }
 
-#ifdef _WIN32
-    if (SUCCEEDED(coInit))
-        CoUninitialize();
-#endif
+    writeProfile();
     return 0;
 }
@@ -1,14 +1,16 @@
 #include "CrossPlatformMdlExporter/mdl_model.hpp"
 
 #include <algorithm>
-#include <array>
 #include <cmath>
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <string>
 #include <unordered_map>
 
 #include "CrossPlatformMdlExporter/mdl_types.hpp"
+#include "CrossPlatformMdlExporter/mesh_optimizer.hpp"
 
 namespace
 {
@@ -79,13 +81,36 @@ const T* PtrAtUnchecked(const uint8_t* base, int32_t offset)
     return reinterpret_cast<const T*>(base + offset);
 }
 
-uint32_t InsertVertex(std::vector<Vertex>& vertices, const Vertex& vertex)
+// Hashes the position and texture coordinates; Vertex::operator== settles the rest. Adding
+// 0.0f turns -0.0f into +0.0f so values that compare equal hash equal.
+struct VertexHash
 {
-    auto it = std::find(vertices.begin(), vertices.end(), vertex);
-    if (it != vertices.end())
-        return static_cast<uint32_t>(it - vertices.begin());
-    vertices.push_back(vertex);
-    return static_cast<uint32_t>(vertices.size() - 1);
+    size_t operator()(const Vertex& v) const
+    {
+        const float values[5] = {v.position.x + 0.0f, v.position.y + 0.0f, v.position.z + 0.0f, v.texCoord.x + 0.0f, v.texCoord.y + 0.0f};
+        uint64_t h = 14695981039346656037ull;
+        for (const float value : values)
+        {
+            uint32_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            h = (h ^ bits) * 1099511628211ull;
+        }
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+// Submodel-relative index of every distinct vertex inserted so far.
+using WeldMap = std::unordered_map<Vertex, uint32_t, VertexHash>;
+
+// Welds within the submodel starting at `firstVertex`; returns the index relative to it.
+// `weld` holds that submodel's vertices, so the result is the first equal vertex, as a linear
+// search would find.
+uint32_t InsertVertex(std::vector<Vertex>& vertices, size_t firstVertex, const Vertex& vertex, WeldMap& weld)
+{
+    const auto [it, inserted] = weld.try_emplace(vertex, static_cast<uint32_t>(vertices.size() - firstVertex));
+    if (inserted)
+        vertices.push_back(vertex);
+    return it->second;
 }
 
 struct Quat4f
@@ -117,64 +142,28 @@ Quat4f AngleQuaternion(const Vec3f& anglesRadians)
     return q;
 }
 
-void QuaternionMatrix(const Quat4f& q, float out3x4[3][4])
+void QuaternionMatrix(const Quat4f& q, Mat3x4f& out)
 {
-    out3x4[0][0] = 1.0f - 2.0f * q.y * q.y - 2.0f * q.z * q.z;
-    out3x4[1][0] = 2.0f * q.x * q.y + 2.0f * q.w * q.z;
-    out3x4[2][0] = 2.0f * q.x * q.z - 2.0f * q.w * q.y;
-
-    out3x4[0][1] = 2.0f * q.x * q.y - 2.0f * q.w * q.z;
-    out3x4[1][1] = 1.0f - 2.0f * q.x * q.x - 2.0f * q.z * q.z;
-    out3x4[2][1] = 2.0f * q.y * q.z + 2.0f * q.w * q.x;
+    out.m[0][0] = 1.0f - 2.0f * q.y * q.y - 2.0f * q.z * q.z;
+    out.m[1][0] = 2.0f * q.x * q.y + 2.0f * q.w * q.z;
+    out.m[2][0] = 2.0f * q.x * q.z - 2.0f * q.w * q.y;
 
-    out3x4[0][2] = 2.0f * q.x * q.z + 2.0f * q.w * q.y;
-    out3x4[1][2] = 2.0f * q.y * q.z - 2.0f * q.w * q.x;
-    out3x4[2][2] = 1.0f - 2.0f * q.x * q.x - 2.0f * q.y * q.y;
+    out.m[0][1] = 2.0f * q.x * q.y - 2.0f * q.w * q.z;
+    out.m[1][1] = 1.0f - 2.0f * q.x * q.x - 2.0f * q.z * q.z;
+    out.m[2][1] = 2.0f * q.y * q.z + 2.0f * q.w * q.x;
 
-    out3x4[0][3] = 0.0f;
-    out3x4[1][3] = 0.0f;
-    out3x4[2][3] = 0.0f;
-}
+    out.m[0][2] = 2.0f * q.x * q.z + 2.0f * q.w * q.y;
+    out.m[1][2] = 2.0f * q.y * q.z - 2.0f * q.w * q.x;
+    out.m[2][2] = 1.0f - 2.0f * q.x * q.x - 2.0f * q.y * q.y;
 
-void ConcatTransforms(const float a[3][4], const float b[3][4], float out[3][4])
-{
-    out[0][0] = a[0][0] * b[0][0] + a[0][1] * b[1][0] + a[0][2] * b[2][0];
-    out[0][1] = a[0][0] * b[0][1] + a[0][1] * b[1][1] + a[0][2] * b[2][1];
-    out[0][2] = a[0][0] * b[0][2] + a[0][1] * b[1][2] + a[0][2] * b[2][2];
-    out[0][3] = a[0][0] * b[0][3] + a[0][1] * b[1][3] + a[0][2] * b[2][3] + a[0][3];
-
-    out[1][0] = a[1][0] * b[0][0] + a[1][1] * b[1][0] + a[1][2] * b[2][0];
-    out[1][1] = a[1][0] * b[0][1] + a[1][1] * b[1][1] + a[1][2] * b[2][1];
-    out[1][2] = a[1][0] * b[0][2] + a[1][1] * b[1][2] + a[1][2] * b[2][2];
-    out[1][3] = a[1][0] * b[0][3] + a[1][1] * b[1][3] + a[1][2] * b[2][3] + a[1][3];
-
-    out[2][0] = a[2][0] * b[0][0] + a[2][1] * b[1][0] + a[2][2] * b[2][0];
-    out[2][1] = a[2][0] * b[0][1] + a[2][1] * b[1][1] + a[2][2] * b[2][1];
-    out[2][2] = a[2][0] * b[0][2] + a[2][1] * b[1][2] + a[2][2] * b[2][2];
-    out[2][3] = a[2][0] * b[0][3] + a[2][1] * b[1][3] + a[2][2] * b[2][3] + a[2][3];
+    out.m[0][3] = 0.0f;
+    out.m[1][3] = 0.0f;
+    out.m[2][3] = 0.0f;
 }
 
-Vec3f TransformPoint3x4(const float m[3][4], const Vec3f& p)
+std::vector<Mat3x4f> ComputeDefaultBoneTransforms(const StudioHdr& header, const uint8_t* base)
 {
-    return {
-        p.x * m[0][0] + p.y * m[0][1] + p.z * m[0][2] + m[0][3],
-        p.x * m[1][0] + p.y * m[1][1] + p.z * m[1][2] + m[1][3],
-        p.x * m[2][0] + p.y * m[2][1] + p.z * m[2][2] + m[2][3],
-    };
-}
-
-Vec3f TransformDirection3x4(const float m[3][4], const Vec3f& d)
-{
-    return {
-        d.x * m[0][0] + d.y * m[0][1] + d.z * m[0][2],
-        d.x * m[1][0] + d.y * m[1][1] + d.z * m[1][2],
-        d.x * m[2][0] + d.y * m[2][1] + d.z * m[2][2],
-    };
-}
-
-std::vector<std::array<float, 12>> ComputeDefaultBoneTransforms(const StudioHdr& header, const uint8_t* base)
-{
-    std::vector<std::array<float, 12>> out;
+    std::vector<Mat3x4f> out;
     if (header.numbones <= 0)
         return out;
 
@@ -182,26 +171,15 @@ std::vector<std::array<float, 12>> ComputeDefaultBoneTransforms(const StudioHdr&
 
     const auto* bones = PtrAtUnchecked<MStudioBone>(base, header.boneindex);
 
-    std::vector<std::array<float, 12>> local;
-    local.resize(static_cast<size_t>(header.numbones));
-
+    std::vector<Mat3x4f> local(static_cast<size_t>(header.numbones));
     for (int i = 0; i < header.numbones; i++)
     {
-        float m[3][4]{};
+        Mat3x4f& m = local[static_cast<size_t>(i)];
         const Vec3f angles{bones[i].value[3], bones[i].value[4], bones[i].value[5]};
-        const Quat4f q = AngleQuaternion(angles);
-        QuaternionMatrix(q, m);
-        m[0][3] = bones[i].value[0];
-        m[1][3] = bones[i].value[1];
-        m[2][3] = bones[i].value[2];
-
-        std::array<float, 12> packed{};
-        for (int r = 0; r < 3; r++)
-        {
-            for (int c = 0; c < 4; c++)
-                packed[static_cast<size_t>(r * 4 + c)] = m[r][c];
-        }
-        local[static_cast<size_t>(i)] = packed;
+        QuaternionMatrix(AngleQuaternion(angles), m);
+        m.m[0][3] = bones[i].value[0];
+        m.m[1][3] = bones[i].value[1];
+        m.m[2][3] = bones[i].value[2];
     }
 
     std::vector<uint8_t> built(static_cast<size_t>(header.numbones), 0);
@@ -222,30 +200,7 @@ std::vector<std::array<float, 12>> ComputeDefaultBoneTransforms(const StudioHdr&
 
         self(self, parent);
 
-        float parentM[3][4]{};
-        float localM[3][4]{};
-        float worldM[3][4]{};
-
-        const auto& pPacked = out[static_cast<size_t>(parent)];
-        const auto& lPacked = local[static_cast<size_t>(boneIndex)];
-        for (int r = 0; r < 3; r++)
-        {
-            for (int c = 0; c < 4; c++)
-            {
-                parentM[r][c] = pPacked[static_cast<size_t>(r * 4 + c)];
-                localM[r][c] = lPacked[static_cast<size_t>(r * 4 + c)];
-            }
-        }
-
-        ConcatTransforms(parentM, localM, worldM);
-
-        std::array<float, 12> packed{};
-        for (int r = 0; r < 3; r++)
-        {
-            for (int c = 0; c < 4; c++)
-                packed[static_cast<size_t>(r * 4 + c)] = worldM[r][c];
-        }
-        out[static_cast<size_t>(boneIndex)] = packed;
+        out[static_cast<size_t>(boneIndex)] = Concat(out[static_cast<size_t>(parent)], local[static_cast<size_t>(boneIndex)]);
         built[static_cast<size_t>(boneIndex)] = 1;
     };
 
@@ -255,11 +210,70 @@ std::vector<std::array<float, 12>> ComputeDefaultBoneTransforms(const StudioHdr&
     return out;
 }
 
-TextureRgba LoadTexture(const StudioHdr& textureHeader, const uint8_t* textureBase, const MStudioTexture& tex)
+// Bind-pose positions of every studio vertex of `model`. studiomdl stores vertices sorted by
+// bone, so each run of equal bones goes through the batched kernel in one call.
+void SkinVertices(const uint8_t* base, const MStudioModel& model, const std::vector<Mat3x4f>& boneTransforms, std::vector<Vec3f>& out)
+{
+    const auto count = static_cast<size_t>(std::max(0, model.numverts));
+    const auto* studioVertices = PtrAtUnchecked<MdlVec3>(base, model.vertindex);
+    const auto* studioVertexBones = PtrAtUnchecked<uint8_t>(base, model.vertinfoindex);
+
+    out.resize(count);
+    for (size_t i = 0; i < count; i++)
+        out[i] = {studioVertices[i].x, studioVertices[i].y, studioVertices[i].z};
+
+    for (size_t start = 0; start < count;)
+    {
+        const uint8_t bone = studioVertexBones[start];
+        size_t end = start + 1;
+        while (end < count && studioVertexBones[end] == bone)
+            end++;
+        if (bone < boneTransforms.size())
+            TransformPoints(boneTransforms[bone], out.data() + start, end - start, sizeof(Vec3f), out.data() + start);
+        start = end;
+    }
+}
+
+// Triangle-command corners (an upper bound on the welded vertices) and triangle indices of a
+// mesh, so the geometry arrays can be allocated once up front.
+void CountMeshGeometry(const uint8_t* base, const MStudioMesh& mesh, size_t& corners, size_t& indices)
+{
+    const int16_t* tricmds = PtrAtUnchecked<int16_t>(base, mesh.triindex);
+    int16_t i = 0;
+    while ((i = *(tricmds++)) != 0)
+    {
+        if (i < 0)
+            i = static_cast<int16_t>(-i);
+        const auto n = static_cast<size_t>(std::max<int16_t>(i, 0));
+        corners += n;
+        if (n > 2)
+            indices += (n - 2) * 3;
+        tricmds += n * 4;
+    }
+}
+
+// Scratch reused across the submodels of a file.
+struct LoadScratch
+{
+    std::vector<Vec3f> skinnedPositions;
+    std::vector<uint32_t> stripIndices;
+    WeldMap weld;
+};
+
+// Name fields of the studio structs are fixed arrays, zero-padded but not always terminated.
+template <size_t N>
+std::string FixedString(const char (&chars)[N])
+{
+    return std::string(chars, std::find(chars, chars + N, '\0'));
+}
+
+TextureRgba LoadTexture(const StudioHdr& textureHeader, const uint8_t* textureBase, const MStudioTexture& tex, TextureLayout layout)
 {
     TextureRgba out{};
     out.width = tex.width;
     out.height = tex.height;
+    out.name = FixedString(tex.name);
+    out.flags = tex.flags;
 
     const int size = tex.width * tex.height;
     const auto* indices = PtrAtUnchecked<uint8_t>(textureBase, tex.index);
@@ -280,6 +294,7 @@ TextureRgba LoadTexture(const StudioHdr& textureHeader, const uint8_t* textureBa
         {
             if (indices[i] == 255)
             {
+                out.opaque = false;
                 pixels[pixelOffset + 0] = 0;
                 pixels[pixelOffset + 1] = 0;
                 pixels[pixelOffset + 2] = 0;
@@ -288,36 +303,46 @@ TextureRgba LoadTexture(const StudioHdr& textureHeader, const uint8_t* textureBa
         }
     }
 
+    BuildMipChain(out);
+    SetTextureLayout(out, layout);
+
     (void)textureHeader;
     return out;
 }
 
-Mesh LoadMesh(const StudioHdr& header,
-              const StudioHdr& textureHeader,
+void LoadMesh(const StudioHdr& textureHeader,
               const uint8_t* base,
               const uint8_t* textureBase,
               const MStudioMesh& mesh,
               const MStudioModel& model,
-              const std::vector<std::array<float, 12>>& boneTransforms,
-              std::vector<Vertex>& vertices)
+              const std::vector<Mat3x4f>& boneTransforms,
+              size_t firstVertex,
+              LoadScratch& scratch,
+              ModelGeometry& geometry)
 {
     Mesh out{};
-    out.indices.reserve(2048);
+    out.firstIndex = static_cast<uint32_t>(geometry.indices.size());
 
-    const auto* studioVertices = PtrAtUnchecked<MdlVec3>(base, model.vertindex);
     const auto* studioVertexBones = PtrAtUnchecked<uint8_t>(base, model.vertinfoindex);
     const auto* studioNormals = PtrAtUnchecked<MdlVec3>(base, model.normindex);
 
     const auto* textures = PtrAtUnchecked<MStudioTexture>(textureBase, textureHeader.textureindex);
     const auto* skinRef = PtrAtUnchecked<uint16_t>(textureBase, textureHeader.skinindex);
 
-    out.textureId = skinRef[mesh.skinref];
-
-    const float s = 1.0f / static_cast<float>(textures[out.textureId].width);
-    const float t = 1.0f / static_cast<float>(textures[out.textureId].height);
+    // Without textures (LoadOptions::skipTextures, or a missing or invalid T.mdl) the mesh
+    // stays untextured and keeps its texture coordinates in texels.
+    float s = 1.0f;
+    float t = 1.0f;
+    if (mesh.skinref >= 0 && mesh.skinref < textureHeader.numskinref && skinRef[mesh.skinref] < textureHeader.numtextures)
+    {
+        out.textureId = skinRef[mesh.skinref];
+        s = 1.0f / static_cast<float>(textures[out.textureId].width);
+        t = 1.0f / static_cast<float>(textures[out.textureId].height);
+    }
 
-    std::vector<uint32_t> tempIndices;
-    tempIndices.reserve(2048);
+    const auto& skinnedPositions = scratch.skinnedPositions;
+    auto& stripIndices = scratch.stripIndices;
+    auto& indices = geometry.indices;
 
     const int16_t* tricmds = PtrAtUnchecked<int16_t>(base, mesh.triindex);
     int16_t i = 0;
@@ -331,7 +356,7 @@ Mesh LoadMesh(const StudioHdr& header,
             strip = false;
         }
 
-        tempIndices.clear();
+        stripIndices.clear();
 
         for (; i > 0; i--, tricmds += 4)
         {
@@ -339,114 +364,118 @@ Mesh LoadMesh(const StudioHdr& header,
             const int16_t vertIndex = tricmds[0];
             const int16_t normIndex = tricmds[1];
 
-            const MdlVec3& p = studioVertices[vertIndex];
             const MdlVec3& n = studioNormals[normIndex];
 
-            v.position = {p.x, p.y, p.z};
+            v.position = static_cast<size_t>(vertIndex) < skinnedPositions.size() ? skinnedPositions[static_cast<size_t>(vertIndex)] : Vec3f{};
             v.normal = Normalize({n.x, n.y, n.z});
             v.texCoord = {s * static_cast<float>(tricmds[2]), t * static_cast<float>(tricmds[3])};
             v.bone = studioVertexBones[vertIndex];
 
-            if (!boneTransforms.empty() && v.bone < boneTransforms.size())
-            {
-                float bm[3][4]{};
-                const auto& packed = boneTransforms[static_cast<size_t>(v.bone)];
-                for (int r = 0; r < 3; r++)
-                {
-                    for (int c = 0; c < 4; c++)
-                        bm[r][c] = packed[static_cast<size_t>(r * 4 + c)];
-                }
+            if (v.bone < boneTransforms.size())
+                v.normal = Normalize(TransformDirection(boneTransforms[v.bone], v.normal));
 
-                v.position = TransformPoint3x4(bm, v.position);
-                v.normal = Normalize(TransformDirection3x4(bm, v.normal));
-            }
-
-            tempIndices.push_back(InsertVertex(vertices, v));
+            stripIndices.push_back(InsertVertex(geometry.vertices, firstVertex, v, scratch.weld));
         }
 
         if (strip)
         {
-            for (size_t j = 2; j < tempIndices.size(); j++)
+            for (size_t j = 2; j < stripIndices.size(); j++)
             {
                 if (j % 2)
                 {
-                    out.indices.push_back(tempIndices[j - 1]);
-                    out.indices.push_back(tempIndices[j - 2]);
-                    out.indices.push_back(tempIndices[j]);
+                    indices.push_back(stripIndices[j - 1]);
+                    indices.push_back(stripIndices[j - 2]);
+                    indices.push_back(stripIndices[j]);
                 }
                 else
                 {
-                    out.indices.push_back(tempIndices[j - 2]);
-                    out.indices.push_back(tempIndices[j - 1]);
-                    out.indices.push_back(tempIndices[j]);
+                    indices.push_back(stripIndices[j - 2]);
+                    indices.push_back(stripIndices[j - 1]);
+                    indices.push_back(stripIndices[j]);
                 }
             }
         }
         else
         {
-            for (size_t j = 2; j < tempIndices.size(); j++)
+            for (size_t j = 2; j < stripIndices.size(); j++)
             {
-                out.indices.push_back(tempIndices[0]);
-                out.indices.push_back(tempIndices[j - 1]);
-                out.indices.push_back(tempIndices[j]);
+                indices.push_back(stripIndices[0]);
+                indices.push_back(stripIndices[j - 1]);
+                indices.push_back(stripIndices[j]);
             }
         }
     }
 
-    (void)header;
-    return out;
+    out.indexCount = static_cast<uint32_t>(indices.size() - out.firstIndex);
+    geometry.meshes.push_back(out);
 }
 
-Model LoadModel(const StudioHdr& header,
-                const StudioHdr& textureHeader,
-                const uint8_t* base,
-                const uint8_t* textureBase,
-                const MStudioModel& model,
-                const std::vector<std::array<float, 12>>& boneTransforms)
+void LoadModel(const StudioHdr& textureHeader,
+               const uint8_t* base,
+               const uint8_t* textureBase,
+               const MStudioModel& model,
+               const std::vector<Mat3x4f>& boneTransforms,
+               LoadScratch& scratch,
+               ModelGeometry& geometry)
 {
     Model out{};
-    if (model.nummesh <= 0)
-        return out;
-
-    out.meshes.reserve(static_cast<size_t>(model.nummesh));
-    for (int i = 0; i < model.nummesh; i++)
+    out.firstVertex = static_cast<uint32_t>(geometry.vertices.size());
+    out.firstMesh = static_cast<uint32_t>(geometry.meshes.size());
+    if (model.nummesh > 0)
     {
-        const auto* mesh = PtrAtUnchecked<MStudioMesh>(base, model.meshindex) + i;
-        out.meshes.push_back(LoadMesh(header, textureHeader, base, textureBase, *mesh, model, boneTransforms, out.vertices));
+        SkinVertices(base, model, boneTransforms, scratch.skinnedPositions);
+        scratch.weld.clear();
+        for (int i = 0; i < model.nummesh; i++)
+        {
+            const auto* mesh = PtrAtUnchecked<MStudioMesh>(base, model.meshindex) + i;
+            LoadMesh(textureHeader, base, textureBase, *mesh, model, boneTransforms, out.firstVertex, scratch, geometry);
+        }
+        out.meshCount = static_cast<uint32_t>(model.nummesh);
     }
-
-    return out;
+    out.vertexCount = static_cast<uint32_t>(geometry.vertices.size() - out.firstVertex);
+    geometry.models.push_back(out);
 }
 
-BodyPart LoadBodyPart(const StudioHdr& header,
-                      const StudioHdr& textureHeader,
-                      const uint8_t* base,
-                      const uint8_t* textureBase,
-                      const MStudioBodyParts& bodyPart,
-                      const std::vector<std::array<float, 12>>& boneTransforms)
+void LoadBodyPart(const StudioHdr& textureHeader,
+                  const uint8_t* base,
+                  const uint8_t* textureBase,
+                  const MStudioBodyParts& bodyPart,
+                  const std::vector<Mat3x4f>& boneTransforms,
+                  LoadScratch& scratch,
+                  ModelGeometry& geometry)
 {
     BodyPart out{};
-    if (bodyPart.nummodels <= 0)
-        return out;
-
-    out.models.reserve(static_cast<size_t>(bodyPart.nummodels));
+    out.firstModel = static_cast<uint32_t>(geometry.models.size());
     for (int i = 0; i < bodyPart.nummodels; i++)
     {
         const auto* model = PtrAtUnchecked<MStudioModel>(base, bodyPart.modelindex) + i;
-        out.models.push_back(LoadModel(header, textureHeader, base, textureBase, *model, boneTransforms));
+        LoadModel(textureHeader, base, textureBase, *model, boneTransforms, scratch, geometry);
     }
-    return out;
+    out.modelCount = static_cast<uint32_t>(geometry.models.size() - out.firstModel);
+    geometry.bodyParts.push_back(out);
 }
 } // namespace
 
-bool StudioModelCpu::LoadFromFile(const std::filesystem::path& filePath)
+bool StudioModelCpu::LoadFromFile(const std::filesystem::path& filePath, const LoadOptions& options, Profiler* profiler)
 {
+    ScopedTrace loadTrace(profiler, "LoadFromFile", filePath.u8string());
     filePath_ = filePath;
-    fileData_ = ReadAllBytes(filePath);
+    {
+        ScopedProfile profile(profiler, ProfileStage::FileRead);
+        ScopedTrace trace(profiler, "ReadAllBytes", filePath.u8string());
+        fileData_ = ReadAllBytes(filePath);
+        profile.SetItems(fileData_.size());
+    }
+    fileMemory_.Reset(profiler, MemoryTag::FileData, CapacityBytes(fileData_));
+    textureMemory_.Reset(profiler, MemoryTag::Textures, 0);
+    geometryMemory_.Reset(profiler, MemoryTag::Geometry, 0);
     if (fileData_.empty())
         return false;
-    if (!VerifyStudioFile(fileData_))
-        return false;
+    {
+        ScopedProfile profile(profiler, ProfileStage::Validation);
+        if (!VerifyStudioFile(fileData_))
+            return false;
+    }
 
     base_ = fileData_.data();
     const auto* header = reinterpret_cast<const StudioHdr*>(base_);
@@ -454,10 +483,17 @@ bool StudioModelCpu::LoadFromFile(const std::filesystem::path& filePath)
     textureBase_ = base_;
     const StudioHdr* textureHeader = header;
 
-    if (header->numtextures == 0)
+    if (header->numtextures == 0 && !options.skipTextures)
     {
         const auto texPath = AddSuffixToFileName(filePath, "T");
-        textureFileData_ = ReadAllBytes(texPath);
+        {
+            ScopedProfile profile(profiler, ProfileStage::FileRead);
+            ScopedTrace trace(profiler, "ReadAllBytes", texPath.u8string());
+            textureFileData_ = ReadAllBytes(texPath);
+            profile.SetItems(textureFileData_.size());
+        }
+        fileMemory_.Set(CapacityBytes(fileData_) + CapacityBytes(textureFileData_));
+        ScopedProfile profile(profiler, ProfileStage::Validation);
         if (VerifyStudioFile(textureFileData_))
         {
             textureBase_ = textureFileData_.data();
@@ -478,31 +514,100 @@ bool StudioModelCpu::LoadFromFile(const std::filesystem::path& filePath)
         }
     }
 
-    const auto defaultBoneTransforms = ComputeDefaultBoneTransforms(*header, base_);
+    std::vector<Mat3x4f> defaultBoneTransforms;
+    {
+        ScopedProfile profile(profiler, ProfileStage::BoneTransforms, static_cast<uint64_t>(std::max(0, header->numbones)));
+        defaultBoneTransforms = ComputeDefaultBoneTransforms(*header, base_);
+    }
 
     textures_.clear();
-    bodyParts_.clear();
+    geometry_ = {};
 
-    if (textureHeader->numtextures > 0)
+    if (textureHeader->numtextures > 0 && !options.skipTextures)
     {
+        ScopedProfile profile(profiler, ProfileStage::TextureDecode);
+        uint64_t texels = 0;
         textures_.reserve(static_cast<size_t>(textureHeader->numtextures));
         const auto* studioTextures = PtrAtUnchecked<MStudioTexture>(textureBase_, textureHeader->textureindex);
         for (int i = 0; i < textureHeader->numtextures; i++)
         {
-            textures_.push_back(LoadTexture(*textureHeader, textureBase_, studioTextures[i]));
+            ScopedTrace trace(profiler, "LoadTexture", FixedString(studioTextures[i].name));
+            textures_.push_back(LoadTexture(*textureHeader, textureBase_, studioTextures[i], options.textureLayout));
+            texels += static_cast<uint64_t>(textures_.back().width) * static_cast<uint64_t>(textures_.back().height);
         }
+        profile.SetItems(texels);
+    }
+    uint64_t textureBytes = CapacityBytes(textures_);
+    for (const auto& texture : textures_)
+    {
+        textureBytes += CapacityBytes(texture.rgba) + CapacityBytes(texture.mips);
+        for (const auto& mip : texture.mips)
+            textureBytes += CapacityBytes(mip.rgba);
     }
+    textureMemory_.Set(textureBytes);
 
     if (header->numbodyparts > 0)
     {
-        bodyParts_.reserve(static_cast<size_t>(header->numbodyparts));
+        ScopedProfile profile(profiler, ProfileStage::MeshDecode);
         const auto* studioBodyParts = PtrAtUnchecked<MStudioBodyParts>(base_, header->bodypartindex);
+
+        size_t models = 0;
+        size_t meshes = 0;
+        size_t corners = 0;
+        size_t indices = 0;
+        for (int i = 0; i < header->numbodyparts; i++)
+        {
+            for (int j = 0; j < studioBodyParts[i].nummodels; j++)
+            {
+                const auto* model = PtrAtUnchecked<MStudioModel>(base_, studioBodyParts[i].modelindex) + j;
+                models++;
+                for (int k = 0; k < model->nummesh; k++)
+                {
+                    meshes++;
+                    CountMeshGeometry(base_, *(PtrAtUnchecked<MStudioMesh>(base_, model->meshindex) + k), corners, indices);
+                }
+            }
+        }
+        geometry_.bodyParts.reserve(static_cast<size_t>(header->numbodyparts));
+        geometry_.models.reserve(models);
+        geometry_.meshes.reserve(meshes);
+        geometry_.indices.reserve(indices);
+        geometry_.vertices.reserve(corners);
+
+        LoadScratch scratch;
         for (int i = 0; i < header->numbodyparts; i++)
         {
-            bodyParts_.push_back(LoadBodyPart(*header, *textureHeader, base_, textureBase_, studioBodyParts[i], defaultBoneTransforms));
+            ScopedTrace trace(profiler, "LoadBodyPart", FixedString(studioBodyParts[i].name));
+            LoadBodyPart(*textureHeader, base_, textureBase_, studioBodyParts[i], defaultBoneTransforms, scratch, geometry_);
         }
+        // Welding typically leaves a third to a half of the corners.
+        geometry_.vertices.shrink_to_fit();
+        profile.SetItems(geometry_.vertices.size());
     }
 
+    vertexCacheStats_ = {};
+    if (options.optimizeVertexCache)
+    {
+        ScopedProfile profile(profiler, ProfileStage::MeshDecode);
+        for (const auto& m : geometry_.models)
+        {
+            for (const auto& mesh : geometry_.Meshes(m))
+            {
+                const auto meshIndices = geometry_.Indices(mesh);
+                vertexCacheStats_.triangles += meshIndices.size() / 3;
+                vertexCacheStats_.missesBefore += CountVertexCacheMisses(meshIndices);
+                OptimizeVertexCache(meshIndices, m.vertexCount);
+            }
+            OptimizeVertexFetch(geometry_, m);
+            for (const auto& mesh : geometry_.Meshes(m))
+                vertexCacheStats_.missesAfter += CountVertexCacheMisses(geometry_.Indices(mesh));
+        }
+        profile.SetItems(vertexCacheStats_.triangles);
+    }
+
+    geometryMemory_.Set(CapacityBytes(geometry_.vertices) + CapacityBytes(geometry_.indices) + CapacityBytes(geometry_.meshes) + CapacityBytes(geometry_.models) +
+                        CapacityBytes(geometry_.bodyParts));
+
     if (header->numseqgroups > 1)
     {
         for (int i = 1; i < header->numseqgroups; i++)
@@ -512,11 +617,19 @@ bool StudioModelCpu::LoadFromFile(const std::filesystem::path& filePath)
             if (written <= 0)
                 continue;
             const auto seqPath = AddSuffixToFileName(filePath, suffix);
-            auto buf = ReadAllBytes(seqPath);
+            std::vector<uint8_t> buf;
+            {
+                ScopedProfile profile(profiler, ProfileStage::FileRead);
+                ScopedTrace trace(profiler, "ReadAllBytes", seqPath.u8string());
+                buf = ReadAllBytes(seqPath);
+                profile.SetItems(buf.size());
+            }
+            const TrackedMemory bufMemory(profiler, MemoryTag::FileData, CapacityBytes(buf));
+            ScopedProfile profile(profiler, ProfileStage::Validation);
             if (!VerifySequenceStudioFile(buf))
                 continue;
         }
     }
 
-    return !bodyParts_.empty();
+    return !geometry_.bodyParts.empty();
 }
@@ -0,0 +1,225 @@
+#include "CrossPlatformMdlExporter/mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+// Forsyth's scoring: the three most recent vertices get a fixed score so the next triangle
+// doesn't just continue the strip, older entries decay, and vertices with few remaining
+// triangles get a boost so islands are finished before moving on.
+constexpr int kLruSize = kVertexCacheSize + 3;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+constexpr uint32_t kValenceTableSize = 32;
+
+struct ScoreTables
+{
+    std::array<float, kLruSize> cache{};
+    std::array<float, kValenceTableSize> valence{};
+
+    ScoreTables()
+    {
+        for (int i = 0; i < kLruSize; i++)
+        {
+            if (i < 3)
+                cache[static_cast<size_t>(i)] = kLastTriangleScore;
+            else if (i < kVertexCacheSize)
+                cache[static_cast<size_t>(i)] = std::pow(1.0f - static_cast<float>(i - 3) / static_cast<float>(kVertexCacheSize - 3), kCacheDecayPower);
+        }
+        for (uint32_t i = 1; i < kValenceTableSize; i++)
+            valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+    }
+};
+
+const ScoreTables& GetScoreTables()
+{
+    static const ScoreTables tables;
+    return tables;
+}
+
+float VertexScore(int cachePosition, uint32_t remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+    const auto& tables = GetScoreTables();
+    float score = cachePosition >= 0 ? tables.cache[static_cast<size_t>(cachePosition)] : 0.0f;
+    score += remaining < kValenceTableSize ? tables.valence[remaining] : kValenceBoostScale * std::pow(static_cast<float>(remaining), -kValenceBoostPower);
+    return score;
+}
+} // namespace
+
+uint64_t CountVertexCacheMisses(ArrayView<const uint32_t> indices, int cacheSize)
+{
+    if (indices.empty())
+        return 0;
+
+    // A vertex is cached while fewer than cacheSize misses happened since it was loaded.
+    const uint32_t maxIndex = *std::max_element(indices.begin(), indices.end());
+    std::vector<uint64_t> loadedAt(static_cast<size_t>(maxIndex) + 1, std::numeric_limits<uint64_t>::max());
+    uint64_t misses = 0;
+    for (const uint32_t v : indices)
+    {
+        if (loadedAt[v] != std::numeric_limits<uint64_t>::max() && misses - loadedAt[v] < static_cast<uint64_t>(cacheSize))
+            continue;
+        loadedAt[v] = misses++;
+    }
+    return misses;
+}
+
+void OptimizeVertexCache(ArrayView<uint32_t> indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles of each vertex, CSR; the live ones are the first `remaining[v]` entries.
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(offsets.back());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount, 0.0f);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    // Stamped with the step number while building nextCache, for O(1) membership tests.
+    std::vector<size_t> inNextCache(vertexCount, 0);
+    cache.reserve(kLruSize + 3);
+    nextCache.reserve(kLruSize + 3);
+
+    size_t best = static_cast<size_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    size_t scanStart = 0;
+    for (size_t done = 0; done < triangleCount; done++)
+    {
+        if (best == triangleCount)
+        {
+            // Nothing in the cache touches an open triangle: take the best remaining one.
+            while (emitted[scanStart])
+                scanStart++;
+            best = scanStart;
+            for (size_t t = scanStart + 1; t < triangleCount; t++)
+            {
+                if (!emitted[t] && triangleScore[t] > triangleScore[best])
+                    best = t;
+            }
+        }
+
+        const uint32_t corners[3] = {indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+        output.insert(output.end(), corners, corners + 3);
+        emitted[best] = true;
+
+        for (const uint32_t v : corners)
+        {
+            const uint32_t first = offsets[v];
+            for (uint32_t i = first; i < first + remaining[v]; i++)
+            {
+                if (adjacency[i] == best)
+                {
+                    adjacency[i] = adjacency[first + remaining[v] - 1];
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the LRU list.
+        nextCache.clear();
+        for (const uint32_t v : corners)
+        {
+            if (inNextCache[v] != done + 1)
+            {
+                inNextCache[v] = done + 1;
+                nextCache.push_back(v);
+            }
+        }
+        for (const uint32_t v : cache)
+        {
+            if (inNextCache[v] != done + 1)
+            {
+                inNextCache[v] = done + 1;
+                nextCache.push_back(v);
+            }
+        }
+        for (size_t i = 0; i < nextCache.size(); i++)
+        {
+            const uint32_t v = nextCache[i];
+            cachePosition[v] = i < static_cast<size_t>(kLruSize) ? static_cast<int>(i) : -1;
+            vertexScore[v] = VertexScore(cachePosition[v] < kVertexCacheSize ? cachePosition[v] : -1, remaining[v]);
+        }
+
+        // Rescore the open triangles of every vertex whose score changed, including the ones
+        // that just fell out of the cache, and continue with the best of them.
+        best = triangleCount;
+        float bestScore = -1.0f;
+        for (const uint32_t v : nextCache)
+        {
+            for (uint32_t i = offsets[v]; i < offsets[v] + remaining[v]; i++)
+            {
+                const uint32_t t = adjacency[i];
+                triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    best = t;
+                    bestScore = triangleScore[t];
+                }
+            }
+        }
+        if (nextCache.size() > static_cast<size_t>(kLruSize))
+            nextCache.resize(kLruSize);
+        cache.swap(nextCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void OptimizeVertexFetch(ModelGeometry& geometry, const Model& model)
+{
+    constexpr uint32_t kUnassigned = std::numeric_limits<uint32_t>::max();
+    const ArrayView<Vertex> source = geometry.Vertices(model);
+    std::vector<uint32_t> remap(source.size(), kUnassigned);
+    std::vector<Vertex> vertices;
+    vertices.reserve(source.size());
+
+    for (const auto& mesh : geometry.Meshes(model))
+    {
+        for (auto& index : geometry.Indices(mesh))
+        {
+            if (remap[index] == kUnassigned)
+            {
+                remap[index] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(source[index]);
+            }
+            index = remap[index];
+        }
+    }
+    for (size_t v = 0; v < source.size(); v++)
+    {
+        if (remap[v] == kUnassigned)
+            vertices.push_back(source[v]);
+    }
+    std::copy(vertices.begin(), vertices.end(), source.begin());
+}
@@ -0,0 +1,799 @@
+#include "CrossPlatformMdlExporter/png_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+struct Crc32Tables
+{
+    uint32_t t[8][256]{};
+
+    Crc32Tables()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : (c >> 1);
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (int k = 1; k < 8; k++)
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+        }
+    }
+};
+
+const Crc32Tables& GetCrc32Tables()
+{
+    static const Crc32Tables tables;
+    return tables;
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& out)
+        : out_(out)
+    {
+    }
+
+    // Deflate packs bits LSB first; Huffman codes are stored pre-reversed.
+    void Write(uint32_t bits, int count)
+    {
+        buffer_ |= static_cast<uint64_t>(bits) << count_;
+        count_ += count;
+        if (count_ >= 32)
+        {
+            const uint8_t bytes[4] = {static_cast<uint8_t>(buffer_), static_cast<uint8_t>(buffer_ >> 8), static_cast<uint8_t>(buffer_ >> 16), static_cast<uint8_t>(buffer_ >> 24)};
+            out_.insert(out_.end(), bytes, bytes + 4);
+            buffer_ >>= 32;
+            count_ -= 32;
+        }
+    }
+
+    void AlignToByte()
+    {
+        while (count_ > 0)
+        {
+            out_.push_back(static_cast<uint8_t>(buffer_));
+            buffer_ >>= 8;
+            count_ -= 8;
+        }
+        buffer_ = 0;
+        count_ = 0;
+    }
+
+    void WriteAlignedBytes(const uint8_t* data, size_t size) { out_.insert(out_.end(), data, data + size); }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t buffer_{};
+    int count_{};
+};
+
+constexpr int kMaxMatch = 258;
+constexpr int kMinMatch = 3;
+constexpr int kWindowSize = 32768;
+constexpr int kLitLenSymbols = 288;
+constexpr int kDistSymbols = 30;
+constexpr int kCodeLengthSymbols = 19;
+constexpr int kEndOfBlock = 256;
+
+constexpr std::array<uint16_t, 29> kLengthBase = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> kLengthExtra = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> kDistBase = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> kDistExtra = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr std::array<uint8_t, 19> kCodeLengthOrder = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct LengthSymbols
+{
+    std::array<uint8_t, kMaxMatch + 1> code{};
+
+    LengthSymbols()
+    {
+        for (size_t c = 0; c < kLengthBase.size(); c++)
+        {
+            const int last = c + 1 == kLengthBase.size() ? kMaxMatch : kLengthBase[c] + (1 << kLengthExtra[c]) - 1;
+            for (int len = kLengthBase[c]; len <= last; len++)
+                code[static_cast<size_t>(len)] = static_cast<uint8_t>(c);
+        }
+    }
+};
+
+const LengthSymbols& GetLengthSymbols()
+{
+    static const LengthSymbols symbols;
+    return symbols;
+}
+
+int GetDistanceCode(int distance)
+{
+    return static_cast<int>(std::upper_bound(kDistBase.begin(), kDistBase.end(), distance) - kDistBase.begin()) - 1;
+}
+
+uint16_t ReverseBits(uint32_t code, int length)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < length; i++)
+    {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return static_cast<uint16_t>(r);
+}
+
+void BuildCanonicalCodes(const uint8_t* lengths, size_t count, uint16_t* codes)
+{
+    std::array<uint16_t, 16> lengthCount{};
+    for (size_t i = 0; i < count; i++)
+        lengthCount[lengths[i]]++;
+    lengthCount[0] = 0;
+
+    std::array<uint32_t, 16> nextCode{};
+    uint32_t code = 0;
+    for (int bits = 1; bits < 16; bits++)
+    {
+        code = (code + lengthCount[static_cast<size_t>(bits - 1)]) << 1;
+        nextCode[static_cast<size_t>(bits)] = code;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (lengths[i] != 0)
+            codes[i] = ReverseBits(nextCode[lengths[i]]++, lengths[i]);
+    }
+}
+
+// Huffman code lengths limited to maxBits. If the tree comes out too deep the frequencies
+// are flattened and the tree rebuilt, which converges in a few rounds.
+void BuildCodeLengths(const uint32_t* freq, size_t count, int maxBits, uint8_t* lengths)
+{
+    std::fill(lengths, lengths + count, uint8_t{0});
+    std::vector<uint32_t> weights(freq, freq + count);
+
+    std::vector<uint32_t> symbols;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (weights[i] != 0)
+            symbols.push_back(static_cast<uint32_t>(i));
+    }
+    if (symbols.empty())
+        return;
+    if (symbols.size() == 1)
+    {
+        // A lone code is padded with a second one so the code is complete.
+        lengths[symbols[0]] = 1;
+        lengths[symbols[0] == 0 ? 1 : 0] = 1;
+        return;
+    }
+
+    const size_t leafCount = symbols.size();
+    std::vector<uint32_t> nodeWeight(leafCount * 2 - 1);
+    std::vector<uint32_t> parent(leafCount * 2 - 1);
+    std::vector<uint8_t> depth(leafCount * 2 - 1);
+    for (;;)
+    {
+        std::sort(symbols.begin(), symbols.end(), [&](uint32_t a, uint32_t b) { return weights[a] != weights[b] ? weights[a] < weights[b] : a < b; });
+        for (size_t i = 0; i < leafCount; i++)
+            nodeWeight[i] = weights[symbols[i]];
+
+        // Two-queue construction: leaves sorted by weight, internal nodes created in
+        // non-decreasing weight order, so both queues stay sorted.
+        size_t nextLeaf = 0;
+        size_t nextInternal = leafCount;
+        auto takeMin = [&](size_t created) {
+            if (nextLeaf < leafCount && (nextInternal >= created || nodeWeight[nextLeaf] <= nodeWeight[nextInternal]))
+                return nextLeaf++;
+            return nextInternal++;
+        };
+        for (size_t node = leafCount; node < leafCount * 2 - 1; node++)
+        {
+            const size_t a = takeMin(node);
+            const size_t b = takeMin(node);
+            nodeWeight[node] = nodeWeight[a] + nodeWeight[b];
+            parent[a] = static_cast<uint32_t>(node);
+            parent[b] = static_cast<uint32_t>(node);
+        }
+
+        const size_t root = leafCount * 2 - 2;
+        depth[root] = 0;
+        int maxDepth = 0;
+        for (size_t node = root; node-- > 0;)
+        {
+            depth[node] = static_cast<uint8_t>(depth[parent[node]] + 1);
+            if (node < leafCount)
+                maxDepth = std::max(maxDepth, static_cast<int>(depth[node]));
+        }
+
+        if (maxDepth <= maxBits)
+        {
+            for (size_t i = 0; i < leafCount; i++)
+                lengths[symbols[i]] = depth[i];
+            return;
+        }
+        for (uint32_t s : symbols)
+            weights[s] = (weights[s] + 1) / 2;
+    }
+}
+
+struct Token
+{
+    uint16_t length{};
+    // 0 for a literal byte stored in `length`.
+    uint16_t distance{};
+};
+
+struct HuffmanTable
+{
+    std::array<uint8_t, kLitLenSymbols> litLengths{};
+    std::array<uint16_t, kLitLenSymbols> litCodes{};
+    std::array<uint8_t, 32> distLengths{};
+    std::array<uint16_t, 32> distCodes{};
+};
+
+const HuffmanTable& GetFixedTable()
+{
+    static const HuffmanTable table = [] {
+        HuffmanTable t{};
+        for (int i = 0; i < kLitLenSymbols; i++)
+            t.litLengths[static_cast<size_t>(i)] = static_cast<uint8_t>(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+        std::fill(t.distLengths.begin(), t.distLengths.end(), uint8_t{5});
+        BuildCanonicalCodes(t.litLengths.data(), t.litLengths.size(), t.litCodes.data());
+        BuildCanonicalCodes(t.distLengths.data(), t.distLengths.size(), t.distCodes.data());
+        return t;
+    }();
+    return table;
+}
+
+void WriteToken(BitWriter& writer, const HuffmanTable& table, const Token& token)
+{
+    if (token.distance == 0)
+    {
+        writer.Write(table.litCodes[token.length], table.litLengths[token.length]);
+        return;
+    }
+
+    const int lengthCode = GetLengthSymbols().code[token.length];
+    const size_t lengthSymbol = static_cast<size_t>(257 + lengthCode);
+    writer.Write(table.litCodes[lengthSymbol], table.litLengths[lengthSymbol]);
+    if (kLengthExtra[static_cast<size_t>(lengthCode)] != 0)
+        writer.Write(token.length - kLengthBase[static_cast<size_t>(lengthCode)], kLengthExtra[static_cast<size_t>(lengthCode)]);
+
+    const auto distCode = static_cast<size_t>(GetDistanceCode(token.distance));
+    writer.Write(table.distCodes[distCode], table.distLengths[distCode]);
+    if (kDistExtra[distCode] != 0)
+        writer.Write(token.distance - kDistBase[distCode], kDistExtra[distCode]);
+}
+
+size_t CountBlockBits(const HuffmanTable& table, const std::array<uint32_t, kLitLenSymbols>& litFreq, const std::array<uint32_t, 32>& distFreq)
+{
+    size_t bits = 0;
+    for (size_t i = 0; i < 257; i++)
+        bits += static_cast<size_t>(litFreq[i]) * table.litLengths[i];
+    for (size_t c = 0; c < kLengthBase.size(); c++)
+        bits += static_cast<size_t>(litFreq[257 + c]) * (table.litLengths[257 + c] + kLengthExtra[c]);
+    for (size_t c = 0; c < kDistBase.size(); c++)
+        bits += static_cast<size_t>(distFreq[c]) * (table.distLengths[c] + kDistExtra[c]);
+    return bits;
+}
+
+struct CodeLengthSymbol
+{
+    uint8_t symbol{};
+    uint8_t extra{};
+};
+
+// Dynamic block header: the literal/length and distance code lengths, run-length coded
+// with symbols 16-18 and themselves Huffman coded.
+struct DynamicHeader
+{
+    int hlit{};
+    int hdist{};
+    int hclen{};
+    std::vector<CodeLengthSymbol> symbols;
+    std::array<uint8_t, kCodeLengthSymbols> lengths{};
+    std::array<uint16_t, kCodeLengthSymbols> codes{};
+    size_t bits{};
+};
+
+void BuildDynamicHeader(const HuffmanTable& table, DynamicHeader& header)
+{
+    header.hlit = 286;
+    while (header.hlit > 257 && table.litLengths[static_cast<size_t>(header.hlit - 1)] == 0)
+        header.hlit--;
+    header.hdist = 30;
+    while (header.hdist > 1 && table.distLengths[static_cast<size_t>(header.hdist - 1)] == 0)
+        header.hdist--;
+
+    std::vector<uint8_t> all(table.litLengths.begin(), table.litLengths.begin() + header.hlit);
+    all.insert(all.end(), table.distLengths.begin(), table.distLengths.begin() + header.hdist);
+
+    header.symbols.clear();
+    for (size_t i = 0; i < all.size();)
+    {
+        const uint8_t len = all[i];
+        size_t run = 1;
+        while (i + run < all.size() && all[i + run] == len)
+            run++;
+        i += run;
+
+        if (len == 0)
+        {
+            while (run >= 3)
+            {
+                const size_t r = std::min<size_t>(run, 138);
+                if (r >= 11)
+                    header.symbols.push_back({18, static_cast<uint8_t>(r - 11)});
+                else
+                    header.symbols.push_back({17, static_cast<uint8_t>(r - 3)});
+                run -= r;
+            }
+        }
+        else
+        {
+            header.symbols.push_back({len, 0});
+            run--;
+            while (run >= 3)
+            {
+                const size_t r = std::min<size_t>(run, 6);
+                header.symbols.push_back({16, static_cast<uint8_t>(r - 3)});
+                run -= r;
+            }
+        }
+        for (; run > 0; run--)
+            header.symbols.push_back({len, 0});
+    }
+
+    std::array<uint32_t, kCodeLengthSymbols> freq{};
+    for (const auto& s : header.symbols)
+        freq[s.symbol]++;
+    BuildCodeLengths(freq.data(), freq.size(), 7, header.lengths.data());
+    BuildCanonicalCodes(header.lengths.data(), header.lengths.size(), header.codes.data());
+
+    header.hclen = kCodeLengthSymbols;
+    while (header.hclen > 4 && header.lengths[kCodeLengthOrder[static_cast<size_t>(header.hclen - 1)]] == 0)
+        header.hclen--;
+
+    header.bits = 5 + 5 + 4 + 3 * static_cast<size_t>(header.hclen);
+    for (const auto& s : header.symbols)
+        header.bits += header.lengths[s.symbol] + (s.symbol == 16 ? 2 : s.symbol == 17 ? 3 : s.symbol == 18 ? 7 : 0);
+}
+
+void WriteDynamicHeader(BitWriter& writer, const DynamicHeader& header)
+{
+    writer.Write(static_cast<uint32_t>(header.hlit - 257), 5);
+    writer.Write(static_cast<uint32_t>(header.hdist - 1), 5);
+    writer.Write(static_cast<uint32_t>(header.hclen - 4), 4);
+    for (int i = 0; i < header.hclen; i++)
+        writer.Write(header.lengths[kCodeLengthOrder[static_cast<size_t>(i)]], 3);
+    for (const auto& s : header.symbols)
+    {
+        writer.Write(header.codes[s.symbol], header.lengths[s.symbol]);
+        if (s.symbol == 16)
+            writer.Write(s.extra, 2);
+        else if (s.symbol == 17)
+            writer.Write(s.extra, 3);
+        else if (s.symbol == 18)
+            writer.Write(s.extra, 7);
+    }
+}
+
+// Emits the tokens as one block with whichever of the fixed or a fitted dynamic table
+// is smaller.
+void WriteBlock(BitWriter& writer, const std::vector<Token>& tokens, bool final)
+{
+    std::array<uint32_t, kLitLenSymbols> litFreq{};
+    std::array<uint32_t, 32> distFreq{};
+    const auto& lengthSymbols = GetLengthSymbols();
+    for (const auto& t : tokens)
+    {
+        if (t.distance == 0)
+        {
+            litFreq[t.length]++;
+            continue;
+        }
+        litFreq[257 + static_cast<size_t>(lengthSymbols.code[t.length])]++;
+        distFreq[static_cast<size_t>(GetDistanceCode(t.distance))]++;
+    }
+    litFreq[kEndOfBlock] = 1;
+
+    // Some inflaters reject distance trees with fewer than two codes.
+    std::array<uint32_t, 32> distTreeFreq = distFreq;
+    if (std::count_if(distTreeFreq.begin(), distTreeFreq.begin() + kDistSymbols, [](uint32_t f) { return f != 0; }) < 2)
+    {
+        distTreeFreq[0] = std::max(distTreeFreq[0], 1u);
+        distTreeFreq[1] = std::max(distTreeFreq[1], 1u);
+    }
+
+    HuffmanTable dynamic{};
+    BuildCodeLengths(litFreq.data(), 286, 15, dynamic.litLengths.data());
+    BuildCodeLengths(distTreeFreq.data(), kDistSymbols, 15, dynamic.distLengths.data());
+    BuildCanonicalCodes(dynamic.litLengths.data(), dynamic.litLengths.size(), dynamic.litCodes.data());
+    BuildCanonicalCodes(dynamic.distLengths.data(), dynamic.distLengths.size(), dynamic.distCodes.data());
+
+    DynamicHeader header{};
+    BuildDynamicHeader(dynamic, header);
+
+    const HuffmanTable& fixed = GetFixedTable();
+    const bool useDynamic = header.bits + CountBlockBits(dynamic, litFreq, distFreq) < CountBlockBits(fixed, litFreq, distFreq);
+    const HuffmanTable& table = useDynamic ? dynamic : fixed;
+
+    writer.Write(final ? 1u : 0u, 1);
+    writer.Write(useDynamic ? 2u : 1u, 2);
+    if (useDynamic)
+        WriteDynamicHeader(writer, header);
+    for (const auto& t : tokens)
+        WriteToken(writer, table, t);
+    writer.Write(table.litCodes[kEndOfBlock], table.litLengths[kEndOfBlock]);
+}
+
+void DeflateStored(BitWriter& writer, const uint8_t* data, size_t size)
+{
+    size_t pos = 0;
+    do
+    {
+        const size_t chunk = std::min<size_t>(size - pos, 65535);
+        const bool final = pos + chunk == size;
+        writer.Write(final ? 1u : 0u, 1);
+        writer.Write(0, 2);
+        writer.AlignToByte();
+        const uint8_t lengths[4] = {static_cast<uint8_t>(chunk & 0xff), static_cast<uint8_t>(chunk >> 8), static_cast<uint8_t>(~chunk & 0xff), static_cast<uint8_t>((~chunk >> 8) & 0xff)};
+        writer.WriteAlignedBytes(lengths, sizeof(lengths));
+        writer.WriteAlignedBytes(data + pos, chunk);
+        pos += chunk;
+    } while (pos < size);
+}
+
+int MatchLength(const uint8_t* data, size_t pos, size_t candidate, size_t size)
+{
+    const size_t limit = std::min<size_t>(kMaxMatch, size - pos);
+    size_t len = 0;
+    while (len < limit && data[candidate + len] == data[pos + len])
+        len++;
+    return static_cast<int>(len);
+}
+
+// After filtering, flat areas become runs of equal bytes (distance 1) or of equal pixels
+// (distance 4), which is most of what a thumbnail compresses to. No match search, one pass.
+void DeflateFast(BitWriter& writer, const uint8_t* data, size_t size)
+{
+    const HuffmanTable& fixed = GetFixedTable();
+    writer.Write(1, 1);
+    writer.Write(1, 2);
+    for (size_t pos = 0; pos < size;)
+    {
+        int bestLength = 0;
+        int bestDistance = 0;
+        for (const int distance : {1, 4})
+        {
+            if (pos < static_cast<size_t>(distance))
+                continue;
+            const int len = MatchLength(data, pos, pos - static_cast<size_t>(distance), size);
+            if (len > bestLength)
+            {
+                bestLength = len;
+                bestDistance = distance;
+            }
+        }
+
+        Token token{};
+        if (bestLength >= kMinMatch)
+        {
+            token.length = static_cast<uint16_t>(bestLength);
+            token.distance = static_cast<uint16_t>(bestDistance);
+            pos += static_cast<size_t>(bestLength);
+        }
+        else
+        {
+            token.length = data[pos];
+            pos++;
+        }
+        WriteToken(writer, fixed, token);
+    }
+    writer.Write(fixed.litCodes[kEndOfBlock], fixed.litLengths[kEndOfBlock]);
+}
+
+// Greedy LZ77 over hash chains of 3-byte prefixes, split into blocks that each get
+// their own Huffman table.
+void DeflateBest(BitWriter& writer, const uint8_t* data, size_t size)
+{
+    constexpr int kHashBits = 15;
+    constexpr int kMaxChain = 128;
+    constexpr size_t kBlockTokens = 1 << 15;
+
+    std::vector<int32_t> head(size_t{1} << kHashBits, -1);
+    std::vector<int32_t> prev(kWindowSize, -1);
+    auto hashAt = [&](size_t pos) {
+        const uint32_t v = static_cast<uint32_t>(data[pos]) | (static_cast<uint32_t>(data[pos + 1]) << 8) | (static_cast<uint32_t>(data[pos + 2]) << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    };
+    auto insert = [&](size_t pos) {
+        if (pos + kMinMatch > size)
+            return;
+        const uint32_t h = hashAt(pos);
+        prev[pos & (kWindowSize - 1)] = head[h];
+        head[h] = static_cast<int32_t>(pos);
+    };
+
+    std::vector<Token> tokens;
+    tokens.reserve(kBlockTokens);
+    for (size_t pos = 0; pos < size;)
+    {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (pos + kMinMatch <= size)
+        {
+            const int maxLength = static_cast<int>(std::min<size_t>(kMaxMatch, size - pos));
+            int32_t candidate = head[hashAt(pos)];
+            for (int chain = 0; candidate >= 0 && chain < kMaxChain; chain++)
+            {
+                const size_t c = static_cast<size_t>(candidate);
+                if (pos - c > static_cast<size_t>(kWindowSize))
+                    break;
+                if (data[c + static_cast<size_t>(bestLength)] == data[pos + static_cast<size_t>(bestLength)])
+                {
+                    const int len = MatchLength(data, pos, c, size);
+                    if (len > bestLength)
+                    {
+                        bestLength = len;
+                        bestDistance = static_cast<int>(pos - c);
+                        if (len >= maxLength)
+                            break;
+                    }
+                }
+                const int32_t next = prev[c & (kWindowSize - 1)];
+                if (next >= candidate)
+                    break;
+                candidate = next;
+            }
+        }
+
+        if (bestLength >= kMinMatch)
+        {
+            tokens.push_back({static_cast<uint16_t>(bestLength), static_cast<uint16_t>(bestDistance)});
+            for (int k = 0; k < bestLength; k++)
+                insert(pos + static_cast<size_t>(k));
+            pos += static_cast<size_t>(bestLength);
+        }
+        else
+        {
+            tokens.push_back({data[pos], 0});
+            insert(pos);
+            pos++;
+        }
+
+        if (tokens.size() == kBlockTokens && pos < size)
+        {
+            WriteBlock(writer, tokens, false);
+            tokens.clear();
+        }
+    }
+    WriteBlock(writer, tokens, true);
+}
+
+// Branch-free so the per-filter loops below vectorize.
+uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    const int pa = std::abs(static_cast<int>(b) - c);
+    const int pb = std::abs(static_cast<int>(a) - c);
+    const int pc = std::abs(static_cast<int>(a) + b - 2 * c);
+    const uint8_t bc = pb <= pc ? b : c;
+    return (pa <= pb && pa <= pc) ? a : bc;
+}
+
+uint32_t SumAbsResiduals(const uint8_t* row, size_t size)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; i++)
+        sum += static_cast<uint32_t>(std::abs(static_cast<int>(static_cast<int8_t>(row[i]))));
+    return sum;
+}
+
+// One loop per filter with the first pixel (no left neighbour) peeled off, so every loop
+// body is straight-line byte arithmetic. `up` is a zero row for the first scanline.
+void ApplyFilters(const uint8_t* cur, const uint8_t* up, size_t stride, uint8_t* sub, uint8_t* upOut, uint8_t* avg, uint8_t* paeth)
+{
+    for (size_t i = 0; i < 4 && i < stride; i++)
+    {
+        sub[i] = cur[i];
+        upOut[i] = static_cast<uint8_t>(cur[i] - up[i]);
+        avg[i] = static_cast<uint8_t>(cur[i] - (up[i] >> 1));
+        paeth[i] = static_cast<uint8_t>(cur[i] - up[i]);
+    }
+    for (size_t i = 4; i < stride; i++)
+        sub[i] = static_cast<uint8_t>(cur[i] - cur[i - 4]);
+    for (size_t i = 4; i < stride; i++)
+        upOut[i] = static_cast<uint8_t>(cur[i] - up[i]);
+    for (size_t i = 4; i < stride; i++)
+        avg[i] = static_cast<uint8_t>(cur[i] - ((cur[i - 4] + up[i]) >> 1));
+    for (size_t i = 4; i < stride; i++)
+        paeth[i] = static_cast<uint8_t>(cur[i] - Paeth(cur[i - 4], up[i], up[i - 4]));
+}
+
+// Writes each scanline as filter byte + residuals. The adaptive choice is the usual
+// minimum-sum-of-absolute-differences heuristic over all five filters.
+void FilterScanlines(int width, int height, const uint8_t* rgba, bool adaptive, std::vector<uint8_t>& out)
+{
+    const size_t stride = static_cast<size_t>(width) * 4;
+    out.resize((stride + 1) * static_cast<size_t>(height));
+    std::vector<uint8_t> zeroRow(stride, 0);
+    std::vector<uint8_t> candidates(stride * 4);
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* cur = rgba + static_cast<size_t>(y) * stride;
+        const uint8_t* up = y > 0 ? cur - stride : zeroRow.data();
+        uint8_t* dst = out.data() + static_cast<size_t>(y) * (stride + 1);
+        if (!adaptive)
+        {
+            dst[0] = 0;
+            std::memcpy(dst + 1, cur, stride);
+            continue;
+        }
+
+        uint8_t* filtered[5] = {nullptr, candidates.data(), candidates.data() + stride, candidates.data() + stride * 2, candidates.data() + stride * 3};
+        ApplyFilters(cur, up, stride, filtered[1], filtered[2], filtered[3], filtered[4]);
+
+        size_t best = 0;
+        uint32_t bestCost = SumAbsResiduals(cur, stride);
+        for (size_t f = 1; f < 5; f++)
+        {
+            const uint32_t cost = SumAbsResiduals(filtered[f], stride);
+            if (cost < bestCost)
+            {
+                best = f;
+                bestCost = cost;
+            }
+        }
+        dst[0] = static_cast<uint8_t>(best);
+        std::memcpy(dst + 1, best == 0 ? cur : filtered[best], stride);
+    }
+}
+
+void AppendU32BE(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void AppendChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size)
+{
+    AppendU32BE(out, static_cast<uint32_t>(size));
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    AppendU32BE(out, UpdateCrc32(0, out.data() + typeOffset, size + 4));
+}
+} // namespace
+
+uint32_t UpdateCrc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    const auto& t = GetCrc32Tables().t;
+    uint32_t c = ~crc;
+    while (size >= 8)
+    {
+        c ^= static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+        c = t[7][c & 0xff] ^ t[6][(c >> 8) & 0xff] ^ t[5][(c >> 16) & 0xff] ^ t[4][c >> 24] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        c = t[0][(c ^ *data++) & 0xff] ^ (c >> 8);
+    return ~c;
+}
+
+// Sums are reduced modulo 65521 once per block, the largest multiple of 16 below zlib's
+// NMAX (5552) that cannot overflow 32 bits. Inside a block 16-byte groups are folded with
+// position weights, a form compilers vectorize.
+uint32_t UpdateAdler32(uint32_t adler, const uint8_t* data, size_t size)
+{
+    constexpr uint32_t kMod = 65521;
+    constexpr size_t kBlock = 5536;
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+    while (size > 0)
+    {
+        size_t n = std::min(size, kBlock);
+        size -= n;
+        while (n >= 16)
+        {
+            uint32_t sum = 0;
+            uint32_t weighted = 0;
+            for (uint32_t k = 0; k < 16; k++)
+            {
+                sum += data[k];
+                weighted += (16 - k) * data[k];
+            }
+            s2 += s1 * 16 + weighted;
+            s1 += sum;
+            data += 16;
+            n -= 16;
+        }
+        while (n-- > 0)
+        {
+            s1 += *data++;
+            s2 += s1;
+        }
+        s1 %= kMod;
+        s2 %= kMod;
+    }
+    return (s2 << 16) | s1;
+}
+
+bool EncodePngRgba(int width, int height, const std::vector<uint8_t>& rgba, PngCompression compression, std::vector<uint8_t>& out, Profiler* profiler)
+{
+    if (width <= 0 || height <= 0)
+        return false;
+    if (rgba.size() != static_cast<size_t>(width) * static_cast<size_t>(height) * 4)
+        return false;
+
+    std::vector<uint8_t> scanlines;
+    FilterScanlines(width, height, rgba.data(), compression != PngCompression::Stored, scanlines);
+    TrackedMemory workingSet(profiler, MemoryTag::Encoder, CapacityBytes(scanlines));
+
+    std::vector<uint8_t> zlib;
+    zlib.reserve(compression == PngCompression::Stored ? scanlines.size() + scanlines.size() / 65535 * 5 + 16 : scanlines.size() / 4 + 64);
+    zlib.push_back(0x78);
+    zlib.push_back(compression == PngCompression::Best ? 0xDA : 0x01);
+    {
+        BitWriter writer(zlib);
+        switch (compression)
+        {
+            case PngCompression::Stored:
+                DeflateStored(writer, scanlines.data(), scanlines.size());
+                break;
+            case PngCompression::Fast:
+                DeflateFast(writer, scanlines.data(), scanlines.size());
+                break;
+            case PngCompression::Best:
+            default:
+                DeflateBest(writer, scanlines.data(), scanlines.size());
+                break;
+        }
+        writer.AlignToByte();
+    }
+    AppendU32BE(zlib, UpdateAdler32(1, scanlines.data(), scanlines.size()));
+
+    out.clear();
+    out.reserve(zlib.size() + 64);
+    workingSet.Set(CapacityBytes(scanlines) + CapacityBytes(zlib) + CapacityBytes(out));
+    const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    out.insert(out.end(), signature, signature + 8);
+
+    std::vector<uint8_t> ihdr;
+    AppendU32BE(ihdr, static_cast<uint32_t>(width));
+    AppendU32BE(ihdr, static_cast<uint32_t>(height));
+    ihdr.push_back(8); // bit depth
+    ihdr.push_back(6); // RGBA
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    AppendChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+    constexpr size_t kMaxIdat = size_t{1} << 20;
+    for (size_t pos = 0; pos < zlib.size(); pos += kMaxIdat)
+        AppendChunk(out, "IDAT", zlib.data() + pos, std::min(kMaxIdat, zlib.size() - pos));
+    AppendChunk(out, "IEND", nullptr, 0);
+    return true;
+}
+
+bool WritePngRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, PngCompression compression, Profiler* profiler)
+{
+    std::vector<uint8_t> encoded;
+    if (!EncodePngRgba(width, height, rgba, compression, encoded, profiler))
+        return false;
+    const TrackedMemory encodedMemory(profiler, MemoryTag::Encoder, CapacityBytes(encoded));
+
+    std::ofstream out(filePath, std::ios::binary);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,170 @@
+#include "CrossPlatformMdlExporter/profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+std::string EscapeJson(const std::string& s)
+{
+    std::string out;
+    for (const char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+    return out;
+}
+} // namespace
+
+const char* GetProfileStageName(ProfileStage stage)
+{
+    switch (stage)
+    {
+        case ProfileStage::FileRead:
+            return "file_read";
+        case ProfileStage::Validation:
+            return "validation";
+        case ProfileStage::TextureDecode:
+            return "texture_decode";
+        case ProfileStage::MeshDecode:
+            return "mesh_decode";
+        case ProfileStage::BoneTransforms:
+            return "bone_transforms";
+        case ProfileStage::VertexTransform:
+            return "vertex_transform";
+        case ProfileStage::TriangleSetup:
+            return "triangle_setup";
+        case ProfileStage::Rasterization:
+            return "rasterization";
+        case ProfileStage::Shading:
+            return "shading";
+        case ProfileStage::Encode:
+            return "encode";
+        case ProfileStage::Count:
+        default:
+            return "unknown";
+    }
+}
+
+const char* GetMemoryTagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+        case MemoryTag::FileData:
+            return "file_data";
+        case MemoryTag::Textures:
+            return "textures";
+        case MemoryTag::Geometry:
+            return "geometry";
+        case MemoryTag::RenderTargets:
+            return "render_targets";
+        case MemoryTag::Encoder:
+            return "encoder";
+        case MemoryTag::Count:
+        default:
+            return "unknown";
+    }
+}
+
+void WriteProfileTable(std::ostream& out, const Profiler& profiler)
+{
+    uint64_t totalNs = 0;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(ProfileStage::Count); i++)
+        totalNs += profiler.Get(static_cast<ProfileStage>(i)).nanoseconds;
+
+    char line[128]{};
+    std::snprintf(line, sizeof(line), "%-18s %12s %7s %8s %14s\n", "stage", "ms", "%", "calls", "items");
+    out << line;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(ProfileStage::Count); i++)
+    {
+        const auto stage = static_cast<ProfileStage>(i);
+        const auto totals = profiler.Get(stage);
+        if (totals.calls == 0)
+        {
+            std::snprintf(line, sizeof(line), "%-18s %12s %7s %8s %14s\n", GetProfileStageName(stage), "-", "-", "-", "-");
+            out << line;
+            continue;
+        }
+        const double ms = static_cast<double>(totals.nanoseconds) / 1.0e6;
+        const double pct = totalNs > 0 ? 100.0 * static_cast<double>(totals.nanoseconds) / static_cast<double>(totalNs) : 0.0;
+        std::snprintf(line, sizeof(line), "%-18s %12.3f %6.1f%% %8llu %14llu\n", GetProfileStageName(stage), ms, pct,
+                      static_cast<unsigned long long>(totals.calls), static_cast<unsigned long long>(totals.items));
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "%-18s %12.3f\n", "total", static_cast<double>(totalNs) / 1.0e6);
+    out << line;
+    WriteMemoryTable(out, profiler);
+}
+
+void WriteMemoryTable(std::ostream& out, const Profiler& profiler)
+{
+    char line[128]{};
+    std::snprintf(line, sizeof(line), "%-18s %14s %14s\n", "memory", "current bytes", "peak bytes");
+    out << line;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryTag::Count); i++)
+    {
+        const auto tag = static_cast<MemoryTag>(i);
+        const auto totals = profiler.GetMemory(tag);
+        std::snprintf(line, sizeof(line), "%-18s %14llu %14llu\n", GetMemoryTagName(tag), static_cast<unsigned long long>(totals.current),
+                      static_cast<unsigned long long>(totals.peak));
+        out << line;
+    }
+    const auto total = profiler.GetTotalMemory();
+    std::snprintf(line, sizeof(line), "%-18s %14llu %14llu\n", "total", static_cast<unsigned long long>(total.current), static_cast<unsigned long long>(total.peak));
+    out << line;
+}
+
+void WriteProfileJson(std::ostream& out, const Profiler& profiler)
+{
+    out << "{\"stages\":[";
+    for (uint32_t i = 0; i < static_cast<uint32_t>(ProfileStage::Count); i++)
+    {
+        const auto stage = static_cast<ProfileStage>(i);
+        const auto totals = profiler.Get(stage);
+        if (i > 0)
+            out << ",";
+        out << "{\"name\":\"" << GetProfileStageName(stage) << "\",\"ns\":" << totals.nanoseconds << ",\"calls\":" << totals.calls << ",\"items\":" << totals.items << "}";
+    }
+    out << "],\"memory\":[";
+    for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryTag::Count); i++)
+    {
+        const auto tag = static_cast<MemoryTag>(i);
+        const auto totals = profiler.GetMemory(tag);
+        if (i > 0)
+            out << ",";
+        out << "{\"name\":\"" << GetMemoryTagName(tag) << "\",\"current_bytes\":" << totals.current << ",\"peak_bytes\":" << totals.peak << "}";
+    }
+    const auto total = profiler.GetTotalMemory();
+    out << "],\"memory_total\":{\"current_bytes\":" << total.current << ",\"peak_bytes\":" << total.peak << "}}\n";
+}
+
+uint32_t GetTraceThreadId()
+{
+    static std::atomic<uint32_t> next{1};
+    thread_local const uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void WriteTraceJson(std::ostream& out, const Profiler& profiler)
+{
+    auto events = profiler.GetTraceEvents();
+    std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char times[96]{};
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const auto& e = events[i];
+        std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", static_cast<double>(e.startNs) / 1.0e3, static_cast<double>(e.durationNs) / 1.0e3);
+        out << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << e.name << "\",\"cat\":\"cpme\",\"ph\":\"X\"," << times << ",\"pid\":1,\"tid\":" << e.threadId << ",\"args\":{";
+        if (!e.detail.empty())
+            out << "\"detail\":\"" << EscapeJson(e.detail) << "\"" << (e.items > 0 ? "," : "");
+        if (e.items > 0)
+            out << "\"items\":" << e.items;
+        out << "}}";
+    }
+    out << "\n]}\n";
+}
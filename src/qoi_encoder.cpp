@@ -0,0 +1,172 @@
+#include "CrossPlatformMdlExporter/qoi_encoder.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+constexpr uint8_t kOpIndex = 0x00;
+constexpr uint8_t kOpDiff = 0x40;
+constexpr uint8_t kOpLuma = 0x80;
+constexpr uint8_t kOpRun = 0xc0;
+constexpr uint8_t kOpRgb = 0xfe;
+constexpr uint8_t kOpRgba = 0xff;
+constexpr int kMaxRun = 62;
+
+constexpr size_t kHeaderSize = 14;
+constexpr std::array<uint8_t, 8> kEndMarker = {0, 0, 0, 0, 0, 0, 0, 1};
+
+uint8_t* PutU32BE(uint8_t* p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+    return p + 4;
+}
+
+// Ops are written into a fixed chunk that is handed to `flush` whenever the next pixel might
+// not fit, so nothing is sized for the five-bytes-per-pixel worst case.
+constexpr size_t kChunkSize = 64 * 1024;
+// Largest single op (QOI_OP_RGBA); the header and end marker are smaller than a chunk.
+constexpr size_t kMaxOpSize = 5;
+
+bool IsValidImage(int width, int height, const std::vector<uint8_t>& rgba)
+{
+    return width > 0 && height > 0 && rgba.size() == static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+}
+
+template <typename Flush>
+bool EncodeChunked(int width, int height, const std::vector<uint8_t>& rgba, Profiler* profiler, Flush&& flush)
+{
+    if (!IsValidImage(width, height, rgba))
+        return false;
+    const size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+
+    std::vector<uint8_t> chunk(kChunkSize);
+    const TrackedMemory chunkMemory(profiler, MemoryTag::Encoder, CapacityBytes(chunk));
+    uint8_t* const chunkEnd = chunk.data() + chunk.size();
+    uint8_t* p = chunk.data();
+    std::memcpy(p, "qoif", 4);
+    p = PutU32BE(p + 4, static_cast<uint32_t>(width));
+    p = PutU32BE(p, static_cast<uint32_t>(height));
+    *p++ = 4;
+    *p++ = 0;
+
+    std::array<uint32_t, 64> index{};
+    const uint8_t* src = rgba.data();
+    uint32_t prev = 0;
+    const uint8_t opaqueBlack[4] = {0, 0, 0, 255};
+    std::memcpy(&prev, opaqueBlack, 4);
+    int run = 0;
+
+    for (size_t i = 0; i < pixels; i++, src += 4)
+    {
+        // A pixel emits at most a pending run plus one op.
+        if (static_cast<size_t>(chunkEnd - p) < 1 + kMaxOpSize)
+        {
+            if (!flush(chunk.data(), static_cast<size_t>(p - chunk.data())))
+                return false;
+            p = chunk.data();
+        }
+
+        uint32_t px;
+        std::memcpy(&px, src, 4);
+        if (px == prev)
+        {
+            if (++run == kMaxRun)
+            {
+                *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0)
+        {
+            *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+            run = 0;
+        }
+
+        const uint8_t r = src[0];
+        const uint8_t g = src[1];
+        const uint8_t b = src[2];
+        const uint8_t a = src[3];
+        const uint8_t* last = reinterpret_cast<const uint8_t*>(&prev);
+        const size_t slot = static_cast<size_t>(r * 3 + g * 5 + b * 7 + a * 11) & 63;
+        if (index[slot] == px)
+        {
+            *p++ = static_cast<uint8_t>(kOpIndex | slot);
+        }
+        else if (a != last[3])
+        {
+            index[slot] = px;
+            *p++ = kOpRgba;
+            std::memcpy(p, src, 4);
+            p += 4;
+        }
+        else
+        {
+            index[slot] = px;
+            const int dr = static_cast<int8_t>(static_cast<uint8_t>(r - last[0]));
+            const int dg = static_cast<int8_t>(static_cast<uint8_t>(g - last[1]));
+            const int db = static_cast<int8_t>(static_cast<uint8_t>(b - last[2]));
+            const int drg = dr - dg;
+            const int dbg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+            {
+                *p++ = static_cast<uint8_t>(kOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+            }
+            else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7)
+            {
+                *p++ = static_cast<uint8_t>(kOpLuma | (dg + 32));
+                *p++ = static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8));
+            }
+            else
+            {
+                *p++ = kOpRgb;
+                *p++ = r;
+                *p++ = g;
+                *p++ = b;
+            }
+        }
+        prev = px;
+    }
+
+    if (static_cast<size_t>(chunkEnd - p) < 1 + kEndMarker.size())
+    {
+        if (!flush(chunk.data(), static_cast<size_t>(p - chunk.data())))
+            return false;
+        p = chunk.data();
+    }
+    if (run > 0)
+        *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+    std::memcpy(p, kEndMarker.data(), kEndMarker.size());
+    p += kEndMarker.size();
+    return flush(chunk.data(), static_cast<size_t>(p - chunk.data()));
+}
+} // namespace
+
+bool EncodeQoiRgba(int width, int height, const std::vector<uint8_t>& rgba, std::vector<uint8_t>& out, Profiler* profiler)
+{
+    out.clear();
+    TrackedMemory outMemory(profiler, MemoryTag::Encoder);
+    return EncodeChunked(width, height, rgba, profiler, [&](const uint8_t* data, size_t size) {
+        out.insert(out.end(), data, data + size);
+        outMemory.Set(CapacityBytes(out));
+        return true;
+    });
+}
+
+bool WriteQoiRgba(const std::filesystem::path& filePath, int width, int height, const std::vector<uint8_t>& rgba, Profiler* profiler)
+{
+    if (!IsValidImage(width, height, rgba))
+        return false;
+    std::ofstream out(filePath, std::ios::binary);
+    if (!out)
+        return false;
+    return EncodeChunked(width, height, rgba, profiler, [&](const uint8_t* data, size_t size) {
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        return static_cast<bool>(out);
+    });
+}
@@ -1,10 +1,14 @@
 #include "CrossPlatformMdlExporter/rasterizer.hpp"
 
+#include "CrossPlatformMdlExporter/mdl_types.hpp"
+
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <cmath>
+#include <cstring>
 #include <limits>
+#include <thread>
 
 namespace
 {
@@ -15,11 +19,9 @@ struct VertexOut
     float z{};
     float invW{};
     Vec2f uvOverW{};
-    Vec3f normalOverW{};
+    float lightOverW{};
 };
 
-Vec4f ToVec4(const Vec3f& v, float w) { return {v.x, v.y, v.z, w}; }
-
 std::array<uint8_t, 4> GetBackground(BackgroundPreset preset)
 {
     switch (preset)
@@ -44,21 +46,15 @@ bool TryComputeVertexBounds(const StudioModelCpu& model, Vec3f& outMin, Vec3f& o
     Vec3f minP{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
     Vec3f maxP{-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
 
-    for (const auto& bp : model.GetBodyParts())
+    for (const auto& v : model.GetGeometry().vertices)
     {
-        for (const auto& m : bp.models)
-        {
-            for (const auto& v : m.vertices)
-            {
-                any = true;
-                minP.x = std::min(minP.x, v.position.x);
-                minP.y = std::min(minP.y, v.position.y);
-                minP.z = std::min(minP.z, v.position.z);
-                maxP.x = std::max(maxP.x, v.position.x);
-                maxP.y = std::max(maxP.y, v.position.y);
-                maxP.z = std::max(maxP.z, v.position.z);
-            }
-        }
+        any = true;
+        minP.x = std::min(minP.x, v.position.x);
+        minP.y = std::min(minP.y, v.position.y);
+        minP.z = std::min(minP.z, v.position.z);
+        maxP.x = std::max(maxP.x, v.position.x);
+        maxP.y = std::max(maxP.y, v.position.y);
+        maxP.z = std::max(maxP.z, v.position.z);
     }
 
     if (!any)
@@ -68,11 +64,55 @@ bool TryComputeVertexBounds(const StudioModelCpu& model, Vec3f& outMin, Vec3f& o
     return true;
 }
 
-std::array<uint8_t, 4> SampleTexture(const TextureRgba* texture, float u, float v)
+struct MipSelection
 {
-    if (!texture || texture->width <= 0 || texture->height <= 0 || texture->rgba.empty())
-        return {200, 200, 200, 255};
+    TextureLevelView level0{};
+    TextureLevelView level1{};
+    float blend{};
+};
+
+// Level of detail for the whole triangle: ratio of the texel area covered by its UVs to
+// the pixel area it covers on screen. Both areas are doubled, so the factor cancels.
+float ComputeTriangleLod(const TextureRgba& texture, const Vec2f& t0, const Vec2f& t1, const Vec2f& t2, float screenArea)
+{
+    const float du1 = (t1.x - t0.x) * static_cast<float>(texture.width);
+    const float dv1 = (t1.y - t0.y) * static_cast<float>(texture.height);
+    const float du2 = (t2.x - t0.x) * static_cast<float>(texture.width);
+    const float dv2 = (t2.y - t0.y) * static_cast<float>(texture.height);
+    const float texelArea = std::abs(du1 * dv2 - du2 * dv1);
+    if (texelArea <= 0.0f || screenArea <= 0.0f)
+        return 0.0f;
+    return 0.5f * std::log2(texelArea / screenArea);
+}
+
+MipSelection SelectMip(const TextureRgba& texture, float lod, TextureFilter filter)
+{
+    MipSelection out{};
+    const int maxLevel = GetMipLevelCount(texture) - 1;
+    if (filter == TextureFilter::Bilinear || maxLevel == 0 || lod <= 0.0f)
+    {
+        out.level0 = GetMipLevel(texture, 0);
+        return out;
+    }
+
+    if (filter == TextureFilter::NearestMip)
+    {
+        out.level0 = GetMipLevel(texture, std::min(maxLevel, static_cast<int>(lod + 0.5f)));
+        return out;
+    }
+
+    const float clamped = std::min(lod, static_cast<float>(maxLevel));
+    const int level = static_cast<int>(clamped);
+    out.level0 = GetMipLevel(texture, level);
+    out.blend = clamped - static_cast<float>(level);
+    if (out.blend > 0.0f)
+        out.level1 = GetMipLevel(texture, level + 1);
+    return out;
+}
 
+template <TextureLayout Layout>
+void SampleBilinear(const TextureLevelView& texture, float u, float v, float out[4])
+{
     u = u - std::floor(u);
     v = v - std::floor(v);
 
@@ -85,90 +125,628 @@ std::array<uint8_t, 4> SampleTexture(const TextureRgba* texture, float u, float
         return i;
     };
 
-    const float x = u * static_cast<float>(texture->width) - 0.5f;
-    const float y = v * static_cast<float>(texture->height) - 0.5f;
+    const float x = u * static_cast<float>(texture.width) - 0.5f;
+    const float y = v * static_cast<float>(texture.height) - 0.5f;
 
     const int x0 = static_cast<int>(std::floor(x));
     const int y0 = static_cast<int>(std::floor(y));
-    const int x1 = x0 + 1;
-    const int y1 = y0 + 1;
 
     const float tx = x - static_cast<float>(x0);
     const float ty = y - static_cast<float>(y0);
 
-    auto fetch = [&](int xi, int yi, int c) -> float {
-        const int sx = wrap(xi, texture->width);
-        const int sy = wrap(yi, texture->height);
-        const size_t idx = (static_cast<size_t>(sy) * static_cast<size_t>(texture->width) + static_cast<size_t>(sx)) * 4 + static_cast<size_t>(c);
-        return static_cast<float>(texture->rgba[idx]);
-    };
+    const int sx0 = wrap(x0, texture.width);
+    const int sy0 = wrap(y0, texture.height);
+    const int sx1 = wrap(x0 + 1, texture.width);
+    const int sy1 = wrap(y0 + 1, texture.height);
+
+    const uint8_t* t00 = texture.rgba + TexelIndex<Layout>(texture.width, sx0, sy0) * 4;
+    const uint8_t* t10 = texture.rgba + TexelIndex<Layout>(texture.width, sx1, sy0) * 4;
+    const uint8_t* t01 = texture.rgba + TexelIndex<Layout>(texture.width, sx0, sy1) * 4;
+    const uint8_t* t11 = texture.rgba + TexelIndex<Layout>(texture.width, sx1, sy1) * 4;
 
-    std::array<uint8_t, 4> out{};
     for (int c = 0; c < 4; c++)
     {
-        const float c00 = fetch(x0, y0, c);
-        const float c10 = fetch(x1, y0, c);
-        const float c01 = fetch(x0, y1, c);
-        const float c11 = fetch(x1, y1, c);
+        const float c00 = static_cast<float>(t00[c]);
+        const float c10 = static_cast<float>(t10[c]);
+        const float c01 = static_cast<float>(t01[c]);
+        const float c11 = static_cast<float>(t11[c]);
 
         const float cx0 = c00 + (c10 - c00) * tx;
         const float cx1 = c01 + (c11 - c01) * tx;
-        const float cf = cx0 + (cx1 - cx0) * ty;
-        out[c] = ClampU8(static_cast<int>(std::lround(cf)));
+        out[c] = cx0 + (cx1 - cx0) * ty;
+    }
+}
+
+template <TextureLayout Layout>
+std::array<uint8_t, 4> SampleTexture(const MipSelection& mip, float u, float v)
+{
+    float c0[4]{};
+    SampleBilinear<Layout>(mip.level0, u, v, c0);
+    if (mip.blend > 0.0f)
+    {
+        float c1[4]{};
+        SampleBilinear<Layout>(mip.level1, u, v, c1);
+        for (int c = 0; c < 4; c++)
+            c0[c] += (c1[c] - c0[c]) * mip.blend;
     }
+
+    std::array<uint8_t, 4> out{};
+    for (int c = 0; c < 4; c++)
+        out[c] = ClampU8(static_cast<int>(std::lround(c0[c])));
     return out;
 }
 
+uint32_t Div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Integer "over" operator on straight-alpha RGBA. Weights are kept in 1/255^2 units
+// (premultiplied source plus attenuated destination), then divided by the combined
+// alpha. Matches the float formulation within +-1 per channel.
 void BlendOver(uint8_t* dst, const std::array<uint8_t, 4>& src)
 {
-    const float srcA = static_cast<float>(src[3]) / 255.0f;
-    const float dstA = static_cast<float>(dst[3]) / 255.0f;
-    const float outA = srcA + dstA * (1.0f - srcA);
-
-    auto blendChannel = [&](int c) -> uint8_t {
-        const float s = static_cast<float>(src[c]) / 255.0f;
-        const float d = static_cast<float>(dst[c]) / 255.0f;
-        float out = 0.0f;
-        if (outA > 0.0f)
-            out = (s * srcA + d * dstA * (1.0f - srcA)) / outA;
-        return ClampU8(static_cast<int>(std::lround(out * 255.0f)));
-    };
+    const uint32_t srcA = src[3];
+    const uint32_t dstA = dst[3];
+    if (srcA == 255)
+    {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = 255;
+        return;
+    }
 
-    dst[0] = blendChannel(0);
-    dst[1] = blendChannel(1);
-    dst[2] = blendChannel(2);
-    dst[3] = ClampU8(static_cast<int>(std::lround(outA * 255.0f)));
+    const uint32_t invSrcA = 255 - srcA;
+    if (dstA == 255)
+    {
+        dst[0] = static_cast<uint8_t>(Div255(src[0] * srcA + dst[0] * invSrcA));
+        dst[1] = static_cast<uint8_t>(Div255(src[1] * srcA + dst[1] * invSrcA));
+        dst[2] = static_cast<uint8_t>(Div255(src[2] * srcA + dst[2] * invSrcA));
+        return;
+    }
+
+    const uint32_t dstWeight = dstA * invSrcA;
+    const uint32_t outA = srcA * 255 + dstWeight;
+    if (outA == 0)
+    {
+        dst[0] = dst[1] = dst[2] = dst[3] = 0;
+        return;
+    }
+
+    for (int c = 0; c < 3; c++)
+        dst[c] = static_cast<uint8_t>((src[c] * srcA * 255 + dst[c] * dstWeight + outA / 2) / outA);
+    dst[3] = static_cast<uint8_t>(Div255(outA));
+}
+
+// GoldSrc studio lighting (ambient 32, shade 192, lambert wrap 1.5, light travelling
+// straight down), normalized so that a fully lit vertex keeps the texel colour.
+constexpr float kAmbientLight = 32.0f;
+constexpr float kShadeLight = 192.0f;
+constexpr float kLambert = 1.5f;
+
+// Four vertices per step through simd::Float4: the normals are gathered into x/y/z lanes
+// and each vertex ends up as one scalar that is interpolated per pixel. The last partial
+// group is padded with zero normals, so every vertex takes the same path.
+void ComputeVertexLighting(ArrayView<const Vertex> vertices, const Vec3f& lightDir, std::vector<float>& outLight)
+{
+    outLight.resize(vertices.size());
+    const simd::Float4 lx = simd::Splat(lightDir.x);
+    const simd::Float4 ly = simd::Splat(lightDir.y);
+    const simd::Float4 lz = simd::Splat(lightDir.z);
+    const simd::Float4 one = simd::Splat(1.0f);
+    const simd::Float4 zero = simd::Splat(0.0f);
+    const simd::Float4 wrapBias = simd::Splat(kLambert - 1.0f);
+    const simd::Float4 wrapScale = simd::Splat(1.0f / kLambert);
+    const simd::Float4 fullLight = simd::Splat(kAmbientLight + kShadeLight);
+    const simd::Float4 negShade = simd::Splat(-kShadeLight);
+    const simd::Float4 scale = simd::Splat(1.0f / (kAmbientLight + kShadeLight));
+
+    const size_t count = vertices.size();
+    const Vertex* v = vertices.data();
+    float* out = outLight.data();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const size_t lanes = std::min<size_t>(4, count - i);
+        float nx[4] = {};
+        float ny[4] = {};
+        float nz[4] = {};
+        for (size_t k = 0; k < lanes; k++)
+        {
+            nx[k] = v[i + k].normal.x;
+            ny[k] = v[i + k].normal.y;
+            nz[k] = v[i + k].normal.z;
+        }
+
+        const simd::Float4 dot = simd::MulAdd(simd::Load(nz), lz, simd::MulAdd(simd::Load(ny), ly, simd::Mul(simd::Load(nx), lx)));
+        const simd::Float4 lightCos = simd::Min(one, dot);
+        const simd::Float4 wrapped = simd::Max(zero, simd::Mul(simd::Add(lightCos, wrapBias), wrapScale));
+        const simd::Float4 illum = simd::Max(zero, simd::MulAdd(negShade, wrapped, fullLight));
+
+        float light[4];
+        simd::Store(light, simd::Mul(illum, scale));
+        std::copy(light, light + lanes, out + i);
+    }
 }
 
 float EdgeFunction(float ax, float ay, float bx, float by, float cx, float cy)
 {
     return (cx - ax) * (by - ay) - (cy - ay) * (bx - ax);
 }
-} // namespace
 
-bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& options, std::vector<uint8_t>& outRgba, RenderStats* stats)
+// Per-mesh pixel pipeline. Chrome is not a kind of its own: it only replaces the UVs at
+// triangle setup and then runs through the Opaque or Masked kernel.
+enum class MaterialKind : uint8_t
+{
+    Untextured,
+    Opaque,
+    Masked,
+    Additive,
+    // RenderQuality::Draft: every mesh writes its triangle's precomputed colour.
+    Draft,
+};
+
+struct TriangleSetup
+{
+    VertexOut v[3]{};
+    float area{};
+    MipSelection mip{};
+    std::array<uint8_t, 4> draftColor{};
+    uint32_t material{};
+    int minX{};
+    int maxX{};
+    int minY{};
+    int maxY{};
+};
+
+struct Barycentrics
+{
+    float b0{};
+    float b1{};
+    float b2{};
+    float w{};
+    float depth{};
+};
+
+// Rows minY..maxY of the frame; the buffers hold exactly those rows. A full render is one
+// target covering the whole image, a banded render one target per band.
+struct RasterTarget
+{
+    int width{};
+    int minY{};
+    int maxY{};
+    float* depth{};
+    uint8_t* rgba{};
+    uint32_t* visibility{};
+
+    size_t Index(int x, int y) const { return static_cast<size_t>(y - minY) * static_cast<size_t>(width) + static_cast<size_t>(x); }
+};
+
+using ForwardKernel = void (*)(const TriangleSetup* first, const TriangleSetup* last, const RasterTarget& target, RenderStats* stats);
+using ShadeKernel = std::array<uint8_t, 4> (*)(const TriangleSetup& tri, const Barycentrics& b);
+
+struct MeshMaterial
+{
+    const TextureRgba* texture{};
+    MaterialKind kind{MaterialKind::Untextured};
+    bool chrome{};
+    ForwardKernel forward{};
+    ShadeKernel shade{};
+};
+
+MaterialKind ClassifyMaterial(const TextureRgba* texture)
+{
+    if (!texture || texture->width <= 0 || texture->height <= 0 || texture->rgba.empty())
+        return MaterialKind::Untextured;
+    if ((texture->flags & STUDIO_NF_ADDITIVE) != 0)
+        return MaterialKind::Additive;
+    return texture->opaque ? MaterialKind::Opaque : MaterialKind::Masked;
+}
+
+bool ComputeBarycentrics(const TriangleSetup& tri, int x, int y, Barycentrics& out)
+{
+    const VertexOut& o0 = tri.v[0];
+    const VertexOut& o1 = tri.v[1];
+    const VertexOut& o2 = tri.v[2];
+
+    const float px = static_cast<float>(x) + 0.5f;
+    const float py = static_cast<float>(y) + 0.5f;
+
+    const float w0 = EdgeFunction(o1.x, o1.y, o2.x, o2.y, px, py);
+    const float w1 = EdgeFunction(o2.x, o2.y, o0.x, o0.y, px, py);
+    const float w2 = EdgeFunction(o0.x, o0.y, o1.x, o1.y, px, py);
+
+    const bool hasNeg = (w0 < 0.0f) || (w1 < 0.0f) || (w2 < 0.0f);
+    const bool hasPos = (w0 > 0.0f) || (w1 > 0.0f) || (w2 > 0.0f);
+    if (hasNeg && hasPos)
+        return false;
+
+    const float invArea = 1.0f / tri.area;
+    out.b0 = w0 * invArea;
+    out.b1 = w1 * invArea;
+    out.b2 = w2 * invArea;
+
+    const float invW = out.b0 * o0.invW + out.b1 * o1.invW + out.b2 * o2.invW;
+    if (invW <= 0.0f)
+        return false;
+    out.w = 1.0f / invW;
+
+    out.depth = out.b0 * o0.z + out.b1 * o1.z + out.b2 * o2.z;
+    return out.depth >= 0.0f && out.depth <= 1.0f;
+}
+
+Vec2f InterpolateUv(const TriangleSetup& tri, const Barycentrics& b)
+{
+    return {(b.b0 * tri.v[0].uvOverW.x + b.b1 * tri.v[1].uvOverW.x + b.b2 * tri.v[2].uvOverW.x) * b.w,
+            (b.b0 * tri.v[0].uvOverW.y + b.b1 * tri.v[1].uvOverW.y + b.b2 * tri.v[2].uvOverW.y) * b.w};
+}
+
+template <MaterialKind Kind, TextureLayout Layout, bool Lighting>
+std::array<uint8_t, 4> ShadeTexel(const TriangleSetup& tri, const Barycentrics& b)
+{
+    if constexpr (Kind == MaterialKind::Draft)
+        return tri.draftColor;
+    std::array<uint8_t, 4> texel{200, 200, 200, 255};
+    if constexpr (Kind != MaterialKind::Untextured)
+    {
+        const Vec2f uv = InterpolateUv(tri, b);
+        texel = SampleTexture<Layout>(tri.mip, uv.x, uv.y);
+    }
+    if constexpr (Lighting)
+    {
+        const float light = (b.b0 * tri.v[0].lightOverW + b.b1 * tri.v[1].lightOverW + b.b2 * tri.v[2].lightOverW) * b.w;
+        const uint32_t scale = static_cast<uint32_t>(std::clamp(light, 0.0f, 1.0f) * 256.0f);
+        texel[0] = static_cast<uint8_t>((texel[0] * scale + 128) >> 8);
+        texel[1] = static_cast<uint8_t>((texel[1] * scale + 128) >> 8);
+        texel[2] = static_cast<uint8_t>((texel[2] * scale + 128) >> 8);
+    }
+    return texel;
+}
+
+// Saturating add weighted by source alpha; alpha grows with the brightest added channel so
+// additive glows stay visible on a transparent background.
+void BlendAdditive(uint8_t* dst, const std::array<uint8_t, 4>& src)
+{
+    const uint32_t srcA = src[3];
+    uint32_t peak = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        const uint32_t add = Div255(src[c] * srcA);
+        dst[c] = static_cast<uint8_t>(std::min<uint32_t>(255, dst[c] + add));
+        peak = std::max(peak, add);
+    }
+    dst[3] = static_cast<uint8_t>(std::max<uint32_t>(dst[3], peak));
+}
+
+template <MaterialKind Kind>
+void WriteTexel(uint8_t* dst, const std::array<uint8_t, 4>& texel)
+{
+    if constexpr (Kind == MaterialKind::Masked)
+    {
+        BlendOver(dst, texel);
+    }
+    else if constexpr (Kind == MaterialKind::Additive)
+    {
+        BlendAdditive(dst, texel);
+    }
+    else
+    {
+        dst[0] = texel[0];
+        dst[1] = texel[1];
+        dst[2] = texel[2];
+        dst[3] = 255;
+    }
+}
+
+// Forward kernel for a run of triangles sharing one material. Everything that used to be
+// tested per pixel (texture presence, blending, lighting, stats) is a template argument.
+// Additive surfaces depth test but do not write depth.
+template <MaterialKind Kind, TextureLayout Layout, bool Lighting, bool Stats>
+void RasterizeForwardRun(const TriangleSetup* first, const TriangleSetup* last, const RasterTarget& target, RenderStats* stats)
+{
+    float* depth = target.depth;
+    uint8_t* rgba = target.rgba;
+    size_t shaded = 0;
+    size_t written = 0;
+    for (const TriangleSetup* tri = first; tri != last; tri++)
+    {
+        const int minY = std::max(tri->minY, target.minY);
+        const int maxY = std::min(tri->maxY, target.maxY);
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int x = tri->minX; x <= tri->maxX; x++)
+            {
+                Barycentrics b{};
+                if (!ComputeBarycentrics(*tri, x, y, b))
+                    continue;
+                const size_t di = target.Index(x, y);
+                if (b.depth >= depth[di])
+                    continue;
+
+                const auto texel = ShadeTexel<Kind, Layout, Lighting>(*tri, b);
+                if constexpr (Stats)
+                    shaded++;
+                if constexpr (Kind == MaterialKind::Masked || Kind == MaterialKind::Additive)
+                {
+                    if (texel[3] == 0)
+                        continue;
+                }
+
+                WriteTexel<Kind>(&rgba[di * 4], texel);
+                if constexpr (Kind != MaterialKind::Additive)
+                    depth[di] = b.depth;
+                if constexpr (Stats)
+                    written++;
+            }
+        }
+    }
+    if constexpr (Stats)
+    {
+        stats->pixelsShaded += shaded;
+        stats->pixelsWritten += written;
+    }
+}
+
+template <MaterialKind Kind, TextureLayout Layout, bool Lighting>
+void SelectKernels(MeshMaterial& material, bool stats)
+{
+    material.forward = stats ? &RasterizeForwardRun<Kind, Layout, Lighting, true> : &RasterizeForwardRun<Kind, Layout, Lighting, false>;
+    material.shade = &ShadeTexel<Kind, Layout, Lighting>;
+}
+
+template <MaterialKind Kind, TextureLayout Layout>
+void SelectKernels(MeshMaterial& material, bool lighting, bool stats)
+{
+    if (lighting)
+        SelectKernels<Kind, Layout, true>(material, stats);
+    else
+        SelectKernels<Kind, Layout, false>(material, stats);
+}
+
+template <MaterialKind Kind>
+void SelectKernels(MeshMaterial& material, bool lighting, bool stats)
+{
+    if (material.texture && material.texture->layout == TextureLayout::Tiled4x4)
+        SelectKernels<Kind, TextureLayout::Tiled4x4>(material, lighting, stats);
+    else
+        SelectKernels<Kind, TextureLayout::RowMajor>(material, lighting, stats);
+}
+
+void SelectKernels(MeshMaterial& material, bool lighting, bool stats)
+{
+    switch (material.kind)
+    {
+        case MaterialKind::Opaque:
+            SelectKernels<MaterialKind::Opaque>(material, lighting, stats);
+            break;
+        case MaterialKind::Masked:
+            SelectKernels<MaterialKind::Masked>(material, lighting, stats);
+            break;
+        case MaterialKind::Additive:
+            SelectKernels<MaterialKind::Additive>(material, lighting, stats);
+            break;
+        case MaterialKind::Draft:
+            SelectKernels<MaterialKind::Draft, TextureLayout::RowMajor>(material, false, stats);
+            break;
+        case MaterialKind::Untextured:
+        default:
+            SelectKernels<MaterialKind::Untextured, TextureLayout::RowMajor>(material, lighting, stats);
+            break;
+    }
+}
+
+// Triangles are stored mesh by mesh, so each run of equal material ids goes through one kernel.
+template <typename Predicate>
+void RasterizeForward(const std::vector<TriangleSetup>& triangles,
+                      const std::vector<MeshMaterial>& materials,
+                      const RasterTarget& target,
+                      RenderStats* stats,
+                      Predicate include)
+{
+    const TriangleSetup* tri = triangles.data();
+    const TriangleSetup* end = tri + triangles.size();
+    while (tri != end)
+    {
+        const TriangleSetup* runEnd = tri + 1;
+        while (runEnd != end && runEnd->material == tri->material)
+            runEnd++;
+        const MeshMaterial& material = materials[tri->material];
+        if (include(material))
+            material.forward(tri, runEnd, target, stats);
+        tri = runEnd;
+    }
+}
+
+// Masked and additive meshes; everything else is opaque once drawn.
+bool IsBlended(const MeshMaterial& material)
+{
+    return material.kind == MaterialKind::Masked || material.kind == MaterialKind::Additive;
+}
+
+// Visibility pass 1: depth and triangle id of the opaque surfaces only. Masked and additive
+// meshes blend with what is behind them, so they are drawn forward after the resolve.
+void RasterizeVisibility(const std::vector<TriangleSetup>& triangles, const std::vector<MeshMaterial>& materials, const RasterTarget& target)
+{
+    for (size_t t = 0; t < triangles.size(); t++)
+    {
+        const TriangleSetup& tri = triangles[t];
+        const MeshMaterial& material = materials[tri.material];
+        if (IsBlended(material))
+            continue;
+
+        const int minY = std::max(tri.minY, target.minY);
+        const int maxY = std::min(tri.maxY, target.maxY);
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int x = tri.minX; x <= tri.maxX; x++)
+            {
+                Barycentrics b{};
+                if (!ComputeBarycentrics(tri, x, y, b))
+                    continue;
+                const size_t di = target.Index(x, y);
+                if (b.depth >= target.depth[di])
+                    continue;
+                target.depth[di] = b.depth;
+                target.visibility[di] = static_cast<uint32_t>(t) + 1;
+            }
+        }
+    }
+}
+
+// Visibility pass 2: one texture sample per visible pixel. Returns the number of pixels shaded.
+size_t ResolveVisibility(const std::vector<TriangleSetup>& triangles, const std::vector<MeshMaterial>& materials, const RasterTarget& target, RenderStats* stats)
 {
-    const int width = std::max(1, options.width);
-    const int height = std::max(1, options.height);
+    size_t shaded = 0;
+    size_t written = 0;
+    for (int y = target.minY; y <= target.maxY; y++)
+    {
+        for (int x = 0; x < target.width; x++)
+        {
+            const size_t di = target.Index(x, y);
+            if (target.visibility[di] == 0)
+                continue;
+
+            const TriangleSetup& tri = triangles[target.visibility[di] - 1];
+            const MeshMaterial& material = materials[tri.material];
+            Barycentrics b{};
+            (void)ComputeBarycentrics(tri, x, y, b);
 
-    outRgba.assign(static_cast<size_t>(width) * static_cast<size_t>(height) * 4, 0);
+            const auto texel = material.shade(tri, b);
+            shaded++;
+            if (texel[3] == 0)
+                continue;
+
+            WriteTexel<MaterialKind::Opaque>(&target.rgba[di * 4], texel);
+            written++;
+        }
+    }
     if (stats)
-        *stats = {};
+    {
+        stats->pixelsShaded += shaded;
+        stats->pixelsWritten += written;
+    }
+    return shaded;
+}
 
-    const auto bg = GetBackground(options.background);
-    for (int y = 0; y < height; y++)
+// GoldSrc chrome: texture coordinates follow the view-space normal, 64 texels across the
+// hemisphere regardless of texture size.
+void ComputeChromeUv(ArrayView<const Vertex> vertices, const Mat4f& modelView, std::vector<Vec2f>& outUv)
+{
+    outUv.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
     {
-        for (int x = 0; x < width; x++)
+        const Vec3f& n = vertices[i].normal;
+        const Vec3f viewNormal = Normalize({modelView.m[0] * n.x + modelView.m[1] * n.y + modelView.m[2] * n.z,
+                                            modelView.m[4] * n.x + modelView.m[5] * n.y + modelView.m[6] * n.z,
+                                            modelView.m[8] * n.x + modelView.m[9] * n.y + modelView.m[10] * n.z});
+        outUv[i] = {(viewNormal.x + 1.0f) * 32.0f, (1.0f - viewNormal.y) * 32.0f};
+    }
+}
+
+// Fixed-size copies of one 32-bit pixel; compilers turn this into wide stores.
+void FillPixels(uint8_t* dst, size_t pixelCount, const std::array<uint8_t, 4>& pixel)
+{
+    uint32_t packed = 0;
+    std::memcpy(&packed, pixel.data(), sizeof(packed));
+    for (size_t i = 0; i < pixelCount; i++)
+        std::memcpy(dst + i * 4, &packed, sizeof(packed));
+}
+
+// Draft shading: one grey per triangle from how directly its face normal points along the
+// view axis, which keeps the silhouette and the larger forms readable without textures.
+std::array<uint8_t, 4> ComputeDraftColor(const Vec3f& p0, const Vec3f& p1, const Vec3f& p2, const Mat4f& modelView)
+{
+    const Vec3f n = Cross(p1 - p0, p2 - p0);
+    const float length = Length(n);
+    const float viewZ = modelView.m[8] * n.x + modelView.m[9] * n.y + modelView.m[10] * n.z;
+    const float facing = length > 0.0f ? std::min(1.0f, std::abs(viewZ) / length) : 0.0f;
+    const auto level = static_cast<uint8_t>(64.0f + 176.0f * facing);
+    return {level, level, level, 255};
+}
+
+// Orange right triangle in the top-left corner that marks a draft render; `target` may be
+// any band of an image `imageHeight` rows high.
+void StampDraftMarker(const RasterTarget& target, int imageHeight)
+{
+    constexpr std::array<uint8_t, 4> kDraftMarker{255, 144, 0, 255};
+    const int size = std::max(4, std::min(target.width, imageHeight) / 8);
+    for (int y = target.minY; y <= std::min(target.maxY, size - 1); y++)
+        FillPixels(&target.rgba[target.Index(0, y) * 4], static_cast<size_t>(std::min(target.width, size - y)), kDraftMarker);
+}
+
+// v_*.mdl / pv-*.mdl are first-person view models. Compares the file name in place so the
+// check does not allocate on every render.
+bool IsViewModelPath(const std::filesystem::path& filePath)
+{
+    const auto& native = filePath.native();
+    size_t start = native.size();
+    while (start > 0 && native[start - 1] != '/' && native[start - 1] != '\\')
+        start--;
+
+    auto hasPrefix = [&](const char* prefix) {
+        size_t i = start;
+        for (; *prefix != '\0'; prefix++, i++)
         {
-            const size_t idx = (static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)) * 4;
-            outRgba[idx + 0] = bg[0];
-            outRgba[idx + 1] = bg[1];
-            outRgba[idx + 2] = bg[2];
-            outRgba[idx + 3] = bg[3];
+            if (i >= native.size() || static_cast<uint32_t>(native[i]) > 0x7f || std::tolower(static_cast<int>(native[i])) != *prefix)
+                return false;
         }
+        return true;
+    };
+    return hasPrefix("v_") || hasPrefix("pv-");
+}
+} // namespace
+
+struct RenderContext::Buffers
+{
+    std::vector<uint8_t> rgba;
+    std::vector<float> depth;
+    std::vector<uint32_t> visibility;
+    std::vector<VertexOut> projected;
+    std::vector<Vec4f> clip;
+    std::vector<float> vertexLight;
+    std::vector<Vec2f> chromeUv;
+    std::vector<TriangleSetup> triangles;
+    std::vector<MeshMaterial> materials;
+    // Banded rendering: triangle ids per band (CSR) and the gathered triangles of one band.
+    std::vector<uint32_t> binOffsets;
+    std::vector<uint32_t> binTriangles;
+    std::vector<TriangleSetup> bandTriangles;
+
+    TrackedMemory memory;
+
+    uint64_t Bytes() const
+    {
+        return CapacityBytes(rgba) + CapacityBytes(depth) + CapacityBytes(visibility) + CapacityBytes(projected) + CapacityBytes(clip) +
+               CapacityBytes(vertexLight) + CapacityBytes(chromeUv) + CapacityBytes(triangles) + CapacityBytes(materials) +
+               CapacityBytes(binOffsets) + CapacityBytes(binTriangles) + CapacityBytes(bandTriangles);
     }
+};
+
+RenderContext::RenderContext()
+    : buffers_(std::make_unique<Buffers>())
+{
+}
+
+RenderContext::~RenderContext() = default;
+RenderContext::RenderContext(RenderContext&&) noexcept = default;
+RenderContext& RenderContext::operator=(RenderContext&&) noexcept = default;
 
-    std::vector<float> depth(static_cast<size_t>(width) * static_cast<size_t>(height), 1.0f);
+const std::vector<uint8_t>& RenderContext::GetRgba() const { return buffers_->rgba; }
+
+std::vector<uint8_t> RenderContext::ReleaseRgba()
+{
+    width_ = 0;
+    height_ = 0;
+    std::vector<uint8_t> rgba = std::move(buffers_->rgba);
+    buffers_->memory.Set(buffers_->Bytes());
+    return rgba;
+}
+
+void RenderContext::SetupTriangles(const StudioModelCpu& model, const RenderOptions& options, RenderStats* stats, Profiler* profiler)
+{
+    const int width = width_;
+    const int height = height_;
 
     Vec3f boundsMin = model.GetBoundsMin();
     Vec3f boundsMax = model.GetBoundsMax();
@@ -181,13 +759,6 @@ bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& optio
     if (widthMeters > heightMeters)
         heightMeters = widthMeters;
 
-    auto guessGunModel = [&]() -> bool {
-        const std::string stem = model.GetFilePath().stem().string();
-        std::string fileName = stem;
-        std::transform(fileName.begin(), fileName.end(), fileName.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        return fileName.rfind("v_", 0) == 0 || fileName.rfind("pv-", 0) == 0;
-    };
-
     auto scaling = [](float sx, float sy, float sz) -> Mat4f {
         Mat4f r{};
         r.m = {sx, 0, 0, 0,
@@ -198,6 +769,18 @@ bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& optio
     };
 
     Mat4f world = scaling(-1.0f, 1.0f, 1.0f);
+    if (options.yawDegrees != 0.0f)
+    {
+        const float yaw = options.yawDegrees * (3.14159265f / 180.0f);
+        const float c = std::cos(yaw);
+        const float s = std::sin(yaw);
+        Mat4f spin{};
+        spin.m = {c, -s, 0, center.x - c * center.x + s * center.y,
+                  s, c, 0, center.y - s * center.x - c * center.y,
+                  0, 0, 1, 0,
+                  0, 0, 0, 1};
+        world = Mul(world, spin);
+    }
 
     Vec3f eye{-50.0f, 0.0f, 0.0f};
     Vec3f at{center.x, center.y, center.z};
@@ -208,7 +791,7 @@ bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& optio
     if (cameraDistance < 0.0f)
         cameraDistance = 50.0f;
 
-    if (guessGunModel())
+    if (IsViewModelPath(model.GetFilePath()))
     {
         eye = {-1.0f, 1.4f, 1.0f};
         at = {-5.0f, 1.4f, 1.0f};
@@ -222,123 +805,369 @@ bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& optio
     const Mat4f view = LookAtLH(eye, at, up);
     const float fovRad = fovDeg * (3.14159265f / 180.0f);
     const Mat4f projection = Perspective(fovRad, static_cast<float>(width) / static_cast<float>(height), 0.01f, 1000.0f);
-    const Mat4f mvp = Mul(projection, Mul(view, world));
+    const Mat4f modelView = Mul(view, world);
+    const Mat4f mvp = Mul(projection, modelView);
 
     const auto& textures = model.GetTextures();
 
-    for (const auto& bodyPart : model.GetBodyParts())
+    std::vector<MeshMaterial>& materials = buffers_->materials;
+    std::vector<TriangleSetup>& triangles = buffers_->triangles;
+    std::vector<VertexOut>& projected = buffers_->projected;
+    std::vector<Vec4f>& clipPositions = buffers_->clip;
+    std::vector<float>& vertexLight = buffers_->vertexLight;
+    std::vector<Vec2f>& chromeUv = buffers_->chromeUv;
+    materials.clear();
+    triangles.clear();
+    const bool draft = options.quality == RenderQuality::Draft;
+    const bool lighting = options.lighting && !draft;
+    const Vec3f lightDir{0.0f, 0.0f, -1.0f};
+    const float viewportX = static_cast<float>(width - 1);
+    const float viewportY = static_cast<float>(height - 1);
+
+    const ModelGeometry& geometry = model.GetGeometry();
+    for (const auto& bodyPart : geometry.bodyParts)
     {
-        if (bodyPart.models.empty())
+        if (bodyPart.modelCount == 0)
             continue;
-        const Model& m = bodyPart.models[0];
+        const Model& m = geometry.models[bodyPart.firstModel];
+        const ArrayView<const Vertex> vertices = geometry.Vertices(m);
+        const ArrayView<const Mesh> meshes = geometry.Meshes(m);
 
-        for (const auto& mesh : m.meshes)
         {
-            const TextureRgba* tex = nullptr;
-            if (mesh.textureId >= 0 && mesh.textureId < static_cast<int>(textures.size()))
-                tex = &textures[static_cast<size_t>(mesh.textureId)];
+            ScopedProfile profile(profiler, ProfileStage::VertexTransform, vertices.size());
+            if (lighting)
+                ComputeVertexLighting(vertices, lightDir, vertexLight);
+            const bool hasChrome = !draft && std::any_of(meshes.begin(), meshes.end(), [&](const Mesh& mesh) {
+                return mesh.textureId >= 0 && mesh.textureId < static_cast<int>(textures.size()) &&
+                       (textures[static_cast<size_t>(mesh.textureId)].flags & STUDIO_NF_CHROME) != 0;
+            });
+            if (hasChrome)
+                ComputeChromeUv(vertices, modelView, chromeUv);
 
-            for (size_t idx = 0; idx + 2 < mesh.indices.size(); idx += 3)
-            {
-                if (stats)
-                    stats->triangles++;
-
-                const Vertex& v0 = m.vertices[mesh.indices[idx + 0]];
-                const Vertex& v1 = m.vertices[mesh.indices[idx + 1]];
-                const Vertex& v2 = m.vertices[mesh.indices[idx + 2]];
-
-                auto project = [&](const Vertex& v) -> VertexOut {
-                    const Vec4f clip = Mul(mvp, ToVec4(v.position, 1.0f));
+            clipPositions.resize(vertices.size());
+            if (!vertices.empty())
+                TransformPoints(mvp, &vertices[0].position, vertices.size(), sizeof(Vertex), clipPositions.data());
 
-                    VertexOut o{};
-                    if (clip.w == 0.0f)
-                        return o;
+            projected.resize(vertices.size());
+            for (size_t vi = 0; vi < vertices.size(); vi++)
+            {
+                const Vertex& v = vertices[vi];
+                const Vec4f& clip = clipPositions[vi];
 
+                VertexOut o{};
+                if (clip.w != 0.0f)
+                {
                     o.invW = 1.0f / clip.w;
                     const float ndcX = clip.x * o.invW;
                     const float ndcY = clip.y * o.invW;
                     const float ndcZ = clip.z * o.invW;
 
-                    o.x = (ndcX * 0.5f + 0.5f) * static_cast<float>(width - 1);
-                    o.y = (1.0f - (ndcY * 0.5f + 0.5f)) * static_cast<float>(height - 1);
+                    o.x = (ndcX * 0.5f + 0.5f) * viewportX;
+                    o.y = (1.0f - (ndcY * 0.5f + 0.5f)) * viewportY;
                     o.z = ndcZ;
-                    return o;
-                };
+                    o.uvOverW = {v.texCoord.x * o.invW, v.texCoord.y * o.invW};
+                    if (lighting)
+                        o.lightOverW = vertexLight[vi] * o.invW;
+                }
+                projected[vi] = o;
+            }
+        }
 
-                VertexOut o0 = project(v0);
-                VertexOut o1 = project(v1);
-                VertexOut o2 = project(v2);
+        ScopedProfile profile(profiler, ProfileStage::TriangleSetup);
+        const size_t firstTriangle = triangles.size();
+        for (const auto& mesh : meshes)
+        {
+            const ArrayView<const uint32_t> indices = geometry.Indices(mesh);
+            MeshMaterial material{};
+            if (!draft && mesh.textureId >= 0 && mesh.textureId < static_cast<int>(textures.size()))
+                material.texture = &textures[static_cast<size_t>(mesh.textureId)];
+            material.kind = draft ? MaterialKind::Draft : ClassifyMaterial(material.texture);
+            material.chrome = material.texture && material.kind != MaterialKind::Untextured && (material.texture->flags & STUDIO_NF_CHROME) != 0;
+            SelectKernels(material, lighting, stats != nullptr);
+            const Vec2f chromeScale = material.chrome ? Vec2f{1.0f / static_cast<float>(material.texture->width), 1.0f / static_cast<float>(material.texture->height)} : Vec2f{};
+            const auto materialIndex = static_cast<uint32_t>(materials.size());
+            materials.push_back(material);
+
+            for (size_t idx = 0; idx + 2 < indices.size(); idx += 3)
+            {
+                if (stats)
+                    stats->triangles++;
 
-                o0.uvOverW = {v0.texCoord.x * o0.invW, v0.texCoord.y * o0.invW};
-                o1.uvOverW = {v1.texCoord.x * o1.invW, v1.texCoord.y * o1.invW};
-                o2.uvOverW = {v2.texCoord.x * o2.invW, v2.texCoord.y * o2.invW};
+                const uint32_t i0 = indices[idx + 0];
+                const uint32_t i1 = indices[idx + 1];
+                const uint32_t i2 = indices[idx + 2];
 
-                const float area = EdgeFunction(o0.x, o0.y, o1.x, o1.y, o2.x, o2.y);
-                if (area == 0.0f)
+                TriangleSetup tri{};
+                tri.v[0] = projected[i0];
+                tri.v[1] = projected[i1];
+                tri.v[2] = projected[i2];
+                Vec2f uv[3] = {vertices[i0].texCoord, vertices[i1].texCoord, vertices[i2].texCoord};
+                if (material.chrome)
+                {
+                    const uint32_t corner[3] = {i0, i1, i2};
+                    for (int k = 0; k < 3; k++)
+                    {
+                        uv[k] = {chromeUv[corner[k]].x * chromeScale.x, chromeUv[corner[k]].y * chromeScale.y};
+                        tri.v[k].uvOverW = {uv[k].x * tri.v[k].invW, uv[k].y * tri.v[k].invW};
+                    }
+                }
+                const VertexOut& o0 = tri.v[0];
+                const VertexOut& o1 = tri.v[1];
+                const VertexOut& o2 = tri.v[2];
+
+                tri.area = EdgeFunction(o0.x, o0.y, o1.x, o1.y, o2.x, o2.y);
+                if (tri.area == 0.0f)
                 {
                     if (stats)
                         stats->degenerateTriangles++;
                     continue;
                 }
 
-                if (area <= 0.0f)
+                if (tri.area <= 0.0f)
                     continue;
 
-                const int minX = std::clamp(static_cast<int>(std::floor(std::min({o0.x, o1.x, o2.x}))), 0, width - 1);
-                const int maxX = std::clamp(static_cast<int>(std::ceil(std::max({o0.x, o1.x, o2.x}))), 0, width - 1);
-                const int minY = std::clamp(static_cast<int>(std::floor(std::min({o0.y, o1.y, o2.y}))), 0, height - 1);
-                const int maxY = std::clamp(static_cast<int>(std::ceil(std::max({o0.y, o1.y, o2.y}))), 0, height - 1);
-
-                for (int y = minY; y <= maxY; y++)
+                if (draft)
                 {
-                    for (int x = minX; x <= maxX; x++)
-                    {
-                        const float px = static_cast<float>(x) + 0.5f;
-                        const float py = static_cast<float>(y) + 0.5f;
-
-                        const float w0 = EdgeFunction(o1.x, o1.y, o2.x, o2.y, px, py);
-                        const float w1 = EdgeFunction(o2.x, o2.y, o0.x, o0.y, px, py);
-                        const float w2 = EdgeFunction(o0.x, o0.y, o1.x, o1.y, px, py);
-
-                        const bool hasNeg = (w0 < 0.0f) || (w1 < 0.0f) || (w2 < 0.0f);
-                        const bool hasPos = (w0 > 0.0f) || (w1 > 0.0f) || (w2 > 0.0f);
-                        if (hasNeg && hasPos)
-                            continue;
-
-                        const float invArea = 1.0f / area;
-                        const float b0 = w0 * invArea;
-                        const float b1 = w1 * invArea;
-                        const float b2 = w2 * invArea;
-
-                        const float invW = b0 * o0.invW + b1 * o1.invW + b2 * o2.invW;
-                        if (invW <= 0.0f)
-                            continue;
-                        const float w = 1.0f / invW;
-
-                        const float depthZ = b0 * o0.z + b1 * o1.z + b2 * o2.z;
-                        const size_t di = static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
-                        if (depthZ < 0.0f || depthZ > 1.0f)
-                            continue;
-                        if (depthZ >= depth[di])
-                            continue;
-
-                        const Vec2f uv = {(b0 * o0.uvOverW.x + b1 * o1.uvOverW.x + b2 * o2.uvOverW.x) * w,
-                                          (b0 * o0.uvOverW.y + b1 * o1.uvOverW.y + b2 * o2.uvOverW.y) * w};
-
-                        auto texel = SampleTexture(tex, uv.x, uv.y);
-                        if (texel[3] == 0)
-                            continue;
-
-                        uint8_t* dst = &outRgba[di * 4];
-                        BlendOver(dst, texel);
-                        depth[di] = depthZ;
-                        if (stats)
-                            stats->pixelsWritten++;
-                    }
+                    tri.draftColor = ComputeDraftColor(vertices[i0].position, vertices[i1].position, vertices[i2].position, modelView);
+                }
+                else if (material.kind != MaterialKind::Untextured)
+                {
+                    const float lod = ComputeTriangleLod(*material.texture, uv[0], uv[1], uv[2], tri.area);
+                    tri.mip = SelectMip(*material.texture, lod, options.textureFilter);
                 }
+
+                tri.material = materialIndex;
+                tri.minX = std::clamp(static_cast<int>(std::floor(std::min({o0.x, o1.x, o2.x}))), 0, width - 1);
+                tri.maxX = std::clamp(static_cast<int>(std::ceil(std::max({o0.x, o1.x, o2.x}))), 0, width - 1);
+                tri.minY = std::clamp(static_cast<int>(std::floor(std::min({o0.y, o1.y, o2.y}))), 0, height - 1);
+                tri.maxY = std::clamp(static_cast<int>(std::ceil(std::max({o0.y, o1.y, o2.y}))), 0, height - 1);
+                triangles.push_back(tri);
             }
         }
+        profile.SetItems(triangles.size() - firstTriangle);
+    }
+
+}
+
+void RenderContext::DrawBand(const RenderOptions& options, bool binned, int minY, int maxY, RenderStats* stats, Profiler* profiler)
+{
+    const auto& triangles = binned ? buffers_->bandTriangles : buffers_->triangles;
+    const auto& materials = buffers_->materials;
+    const size_t pixelCount = static_cast<size_t>(width_) * static_cast<size_t>(maxY - minY + 1);
+
+    buffers_->rgba.resize(pixelCount * 4);
+    FillPixels(buffers_->rgba.data(), pixelCount, GetBackground(options.background));
+    buffers_->depth.resize(pixelCount);
+    std::fill(buffers_->depth.begin(), buffers_->depth.end(), 1.0f);
+
+    RasterTarget target{};
+    target.width = width_;
+    target.minY = minY;
+    target.maxY = maxY;
+    target.depth = buffers_->depth.data();
+    target.rgba = buffers_->rgba.data();
+
+    if (options.shadingMode == ShadingMode::Visibility && options.quality != RenderQuality::Draft)
+    {
+        buffers_->visibility.resize(pixelCount);
+        std::fill(buffers_->visibility.begin(), buffers_->visibility.end(), 0u);
+        target.visibility = buffers_->visibility.data();
+        {
+            ScopedProfile profile(profiler, ProfileStage::Rasterization, triangles.size());
+            RasterizeVisibility(triangles, materials, target);
+        }
+        ScopedProfile profile(profiler, ProfileStage::Shading);
+        const size_t shaded = ResolveVisibility(triangles, materials, target, stats);
+        profile.SetItems(shaded);
+        RasterizeForward(triangles, materials, target, stats, IsBlended);
+        return;
+    }
+
+    // Forward shading samples and blends inside the raster loop, so its shading time is
+    // reported as part of rasterization.
+    ScopedProfile profile(profiler, ProfileStage::Rasterization, triangles.size());
+    RasterizeForward(triangles, materials, target, stats, [](const MeshMaterial&) { return true; });
+    if (options.quality == RenderQuality::Draft)
+        StampDraftMarker(target, height_);
+}
+
+bool RenderContext::Render(const StudioModelCpu& model, const RenderOptions& options, RenderStats* stats, Profiler* profiler)
+{
+    ScopedTrace trace(profiler, "Render");
+    width_ = std::max(1, options.width);
+    height_ = std::max(1, options.height);
+    if (stats)
+        *stats = {};
+
+    SetupTriangles(model, options, stats, profiler);
+    DrawBand(options, false, 0, height_ - 1, stats, profiler);
+    buffers_->memory.Reset(profiler, MemoryTag::RenderTargets, buffers_->Bytes());
+    return true;
+}
+
+bool RenderContext::RenderBanded(const StudioModelCpu& model, const RenderOptions& options, int bandRows, const RenderBandSink& sink, RenderStats* stats, Profiler* profiler)
+{
+    ScopedTrace trace(profiler, "RenderBanded");
+    width_ = std::max(1, options.width);
+    height_ = std::max(1, options.height);
+    bandRows = std::clamp(bandRows, 1, height_);
+    if (stats)
+        *stats = {};
+
+    SetupTriangles(model, options, stats, profiler);
+
+    // Bin triangles by the bands their bounds touch, keeping submission order within a band
+    // so blending and material runs match a full-frame render.
+    const auto& triangles = buffers_->triangles;
+    const size_t bandCount = static_cast<size_t>((height_ + bandRows - 1) / bandRows);
+    auto& offsets = buffers_->binOffsets;
+    auto& ids = buffers_->binTriangles;
+    {
+        ScopedProfile profile(profiler, ProfileStage::TriangleSetup, triangles.size());
+        offsets.assign(bandCount + 1, 0);
+        for (const auto& tri : triangles)
+        {
+            for (int band = tri.minY / bandRows; band <= tri.maxY / bandRows; band++)
+                offsets[static_cast<size_t>(band) + 1]++;
+        }
+        for (size_t band = 0; band < bandCount; band++)
+            offsets[band + 1] += offsets[band];
+
+        ids.resize(offsets[bandCount]);
+        for (size_t t = 0; t < triangles.size(); t++)
+        {
+            for (int band = triangles[t].minY / bandRows; band <= triangles[t].maxY / bandRows; band++)
+                ids[offsets[static_cast<size_t>(band)]++] = static_cast<uint32_t>(t);
+        }
+        // The fill pass advanced every offset to the start of the next band.
+        for (size_t band = bandCount; band > 0; band--)
+            offsets[band] = offsets[band - 1];
+        offsets[0] = 0;
+    }
+
+    auto& bandTriangles = buffers_->bandTriangles;
+    for (size_t band = 0; band < bandCount; band++)
+    {
+        bandTriangles.clear();
+        for (uint32_t i = offsets[band]; i < offsets[band + 1]; i++)
+            bandTriangles.push_back(triangles[ids[i]]);
+
+        const int minY = static_cast<int>(band) * bandRows;
+        const int maxY = std::min(height_, minY + bandRows) - 1;
+        DrawBand(options, true, minY, maxY, stats, profiler);
+        buffers_->memory.Reset(profiler, MemoryTag::RenderTargets, buffers_->Bytes());
+        if (!sink(minY, maxY - minY + 1, buffers_->rgba.data()))
+            return false;
     }
+    return true;
+}
 
+bool RenderThumbnailRgba(const StudioModelCpu& model, const RenderOptions& options, std::vector<uint8_t>& outRgba, RenderStats* stats, Profiler* profiler)
+{
+    RenderContext context;
+    if (!context.Render(model, options, stats, profiler))
+        return false;
+    outRgba = context.ReleaseRgba();
     return true;
 }
+
+std::vector<float> MakeTurntableYaws(int views)
+{
+    std::vector<float> yaws;
+    if (views <= 0)
+        return yaws;
+    yaws.reserve(static_cast<size_t>(views));
+    for (int i = 0; i < views; i++)
+        yaws.push_back(360.0f * static_cast<float>(i) / static_cast<float>(views));
+    return yaws;
+}
+
+bool RenderSpriteSheetRgba(const StudioModelCpu& model,
+                           const RenderOptions& options,
+                           const std::vector<float>& yawDegrees,
+                           int columns,
+                           std::vector<uint8_t>& outRgba,
+                           int& outWidth,
+                           int& outHeight,
+                           RenderStats* stats,
+                           Profiler* profiler)
+{
+    if (yawDegrees.empty())
+        return false;
+    ScopedTrace trace(profiler, "RenderSpriteSheet");
+
+    const int cellWidth = std::max(1, options.width);
+    const int cellHeight = std::max(1, options.height);
+    const int views = static_cast<int>(yawDegrees.size());
+    if (columns <= 0)
+        columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(views))));
+    columns = std::min(columns, views);
+    const int rows = (views + columns - 1) / columns;
+
+    outWidth = cellWidth * columns;
+    outHeight = cellHeight * rows;
+    outRgba.assign(static_cast<size_t>(outWidth) * static_cast<size_t>(outHeight) * 4, 0);
+    const TrackedMemory sheetMemory(profiler, MemoryTag::RenderTargets, CapacityBytes(outRgba));
+
+    FillPixels(outRgba.data(), outRgba.size() / 4, GetBackground(options.background));
+
+    // The model (skinned geometry, decoded textures) is shared read-only; each worker
+    // renders whole views into its own buffer and copies them into disjoint cells.
+    const int workers = std::max(1, std::min(views, static_cast<int>(std::thread::hardware_concurrency())));
+    std::vector<RenderStats> workerStats(static_cast<size_t>(workers));
+    std::vector<uint8_t> workerOk(static_cast<size_t>(workers), 1);
+
+    auto work = [&](int worker) {
+        RenderContext context;
+        RenderOptions viewOptions = options;
+        viewOptions.width = cellWidth;
+        viewOptions.height = cellHeight;
+        for (int view = worker; view < views; view += workers)
+        {
+            viewOptions.yawDegrees = options.yawDegrees + yawDegrees[static_cast<size_t>(view)];
+            RenderStats viewStats{};
+            if (!context.Render(model, viewOptions, stats ? &viewStats : nullptr, profiler))
+            {
+                workerOk[static_cast<size_t>(worker)] = 0;
+                continue;
+            }
+
+            auto& total = workerStats[static_cast<size_t>(worker)];
+            total.triangles += viewStats.triangles;
+            total.degenerateTriangles += viewStats.degenerateTriangles;
+            total.pixelsShaded += viewStats.pixelsShaded;
+            total.pixelsWritten += viewStats.pixelsWritten;
+
+            const int cellX = (view % columns) * cellWidth;
+            const int cellY = (view / columns) * cellHeight;
+            const size_t rowBytes = static_cast<size_t>(cellWidth) * 4;
+            for (int y = 0; y < cellHeight; y++)
+            {
+                const size_t dst = (static_cast<size_t>(cellY + y) * static_cast<size_t>(outWidth) + static_cast<size_t>(cellX)) * 4;
+                std::copy_n(context.GetRgba().data() + static_cast<size_t>(y) * rowBytes, rowBytes, outRgba.data() + dst);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<size_t>(workers - 1));
+    for (int worker = 1; worker < workers; worker++)
+        threads.emplace_back(work, worker);
+    work(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    if (stats)
+    {
+        *stats = {};
+        for (const auto& ws : workerStats)
+        {
+            stats->triangles += ws.triangles;
+            stats->degenerateTriangles += ws.degenerateTriangles;
+            stats->pixelsShaded += ws.pixelsShaded;
+            stats->pixelsWritten += ws.pixelsWritten;
+        }
+    }
+
+    return std::all_of(workerOk.begin(), workerOk.end(), [](uint8_t ok) { return ok != 0; });
+}
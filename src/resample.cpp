@@ -0,0 +1,115 @@
+#include "CrossPlatformMdlExporter/resample.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CrossPlatformMdlExporter/math.hpp"
+
+namespace
+{
+struct Tap
+{
+    int index{};
+    float weight{};
+};
+
+struct TapRange
+{
+    size_t first{};
+    size_t count{};
+};
+
+// For every destination column (or row) the source texels it covers and the
+// fraction of each one, normalized so the weights sum to 1.
+void BuildTaps(int srcSize, int dstSize, std::vector<Tap>& taps, std::vector<TapRange>& ranges)
+{
+    taps.clear();
+    ranges.resize(static_cast<size_t>(dstSize));
+    const double scale = static_cast<double>(srcSize) / static_cast<double>(dstSize);
+    for (int d = 0; d < dstSize; d++)
+    {
+        const double start = static_cast<double>(d) * scale;
+        const double end = std::min(static_cast<double>(srcSize), start + scale);
+        ranges[static_cast<size_t>(d)].first = taps.size();
+        for (int s = static_cast<int>(std::floor(start)); s < srcSize && static_cast<double>(s) < end; s++)
+        {
+            const double covered = std::min(end, static_cast<double>(s + 1)) - std::max(start, static_cast<double>(s));
+            if (covered > 0.0)
+                taps.push_back({s, static_cast<float>(covered / scale)});
+        }
+        ranges[static_cast<size_t>(d)].count = taps.size() - ranges[static_cast<size_t>(d)].first;
+    }
+}
+} // namespace
+
+bool DownscaleRgba(const std::vector<uint8_t>& src, int srcWidth, int srcHeight, std::vector<uint8_t>& dst, int dstWidth, int dstHeight)
+{
+    if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0)
+        return false;
+    if (dstWidth > srcWidth || dstHeight > srcHeight)
+        return false;
+    if (src.size() != static_cast<size_t>(srcWidth) * static_cast<size_t>(srcHeight) * 4)
+        return false;
+
+    std::vector<Tap> xTaps;
+    std::vector<TapRange> xRanges;
+    std::vector<Tap> yTaps;
+    std::vector<TapRange> yRanges;
+    BuildTaps(srcWidth, dstWidth, xTaps, xRanges);
+    BuildTaps(srcHeight, dstHeight, yTaps, yRanges);
+
+    // Horizontal pass into premultiplied float rows, then a vertical pass that accumulates
+    // whole rows at a time. Both work on one RGBA pixel per simd::Float4; there is no fused
+    // multiply-add, so every backend produces the same bytes.
+    std::vector<float> rows(static_cast<size_t>(dstWidth) * static_cast<size_t>(srcHeight) * 4);
+    for (int y = 0; y < srcHeight; y++)
+    {
+        const uint8_t* srcRow = src.data() + static_cast<size_t>(y) * static_cast<size_t>(srcWidth) * 4;
+        float* outRow = rows.data() + static_cast<size_t>(y) * static_cast<size_t>(dstWidth) * 4;
+        for (int x = 0; x < dstWidth; x++)
+        {
+            simd::Float4 acc = simd::Splat(0.0f);
+            const TapRange& range = xRanges[static_cast<size_t>(x)];
+            for (size_t t = range.first; t < range.first + range.count; t++)
+            {
+                const uint8_t* p = srcRow + static_cast<size_t>(xTaps[t].index) * 4;
+                const simd::Float4 texel = simd::Set(static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]), 1.0f);
+                acc = simd::MulAdd(texel, simd::Splat(xTaps[t].weight * static_cast<float>(p[3])), acc);
+            }
+            simd::Store(outRow + static_cast<size_t>(x) * 4, acc);
+        }
+    }
+
+    dst.resize(static_cast<size_t>(dstWidth) * static_cast<size_t>(dstHeight) * 4);
+    const size_t rowFloats = static_cast<size_t>(dstWidth) * 4;
+    std::vector<float> acc(rowFloats);
+    const simd::Float4 zero = simd::Splat(0.0f);
+    const simd::Float4 half = simd::Splat(0.5f);
+    const simd::Float4 maxValue = simd::Splat(255.0f);
+    for (int y = 0; y < dstHeight; y++)
+    {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        const TapRange& range = yRanges[static_cast<size_t>(y)];
+        for (size_t t = range.first; t < range.first + range.count; t++)
+        {
+            const simd::Float4 weight = simd::Splat(yTaps[t].weight);
+            const float* row = rows.data() + static_cast<size_t>(yTaps[t].index) * rowFloats;
+            for (size_t i = 0; i < rowFloats; i += 4)
+                simd::Store(acc.data() + i, simd::MulAdd(simd::Load(row + i), weight, simd::Load(acc.data() + i)));
+        }
+
+        uint8_t* outRow = dst.data() + static_cast<size_t>(y) * rowFloats;
+        for (int x = 0; x < dstWidth; x++)
+        {
+            const float* p = acc.data() + static_cast<size_t>(x) * 4;
+            const float alpha = p[3];
+            const float inv = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+            alignas(16) float rgba[4];
+            const simd::Float4 unpremultiplied = simd::MulAdd(simd::Load(p), simd::Set(inv, inv, inv, 1.0f), half);
+            simd::Store(rgba, simd::Min(maxValue, simd::Max(zero, unpremultiplied)));
+            for (size_t ch = 0; ch < 4; ch++)
+                outRow[static_cast<size_t>(x) * 4 + ch] = static_cast<uint8_t>(rgba[ch]);
+        }
+    }
+    return true;
+}
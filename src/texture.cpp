@@ -0,0 +1,117 @@
+#include "CrossPlatformMdlExporter/texture.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// Source texels [first, first + count) of a row or column that fold into destination texel `d`.
+// Sizes halve rounding down; at an odd size the last destination texel takes three source
+// texels instead of two, so the last row/column isn't dropped.
+void FoldRange(int srcSize, int dstSize, int d, int& first, int& count)
+{
+    first = std::min(d * 2, srcSize - 1);
+    count = std::min(2, srcSize - first);
+    if (d == dstSize - 1 && srcSize > 1 && (srcSize & 1) != 0)
+        count = 3;
+}
+
+// Box filter over 2x2 texels, 2x3/3x2/3x3 along odd edges. Colour is weighted by alpha so
+// that masked (alpha 0, black) texels don't bleed dark fringes into the smaller levels.
+void Downsample(const TextureLevelView& src, TextureMipLevel& dst)
+{
+    dst.width = std::max(1, src.width / 2);
+    dst.height = std::max(1, src.height / 2);
+    dst.rgba.resize(static_cast<size_t>(dst.width) * static_cast<size_t>(dst.height) * 4);
+
+    for (int y = 0; y < dst.height; y++)
+    {
+        int sy = 0;
+        int rows = 0;
+        FoldRange(src.height, dst.height, y, sy, rows);
+        for (int x = 0; x < dst.width; x++)
+        {
+            int sx = 0;
+            int columns = 0;
+            FoldRange(src.width, dst.width, x, sx, columns);
+
+            uint32_t sumA = 0;
+            uint32_t sum[3]{};
+            for (int ty = sy; ty < sy + rows; ty++)
+            {
+                const uint8_t* t = src.rgba + (static_cast<size_t>(ty) * static_cast<size_t>(src.width) + static_cast<size_t>(sx)) * 4;
+                for (int tx = 0; tx < columns; tx++, t += 4)
+                {
+                    sumA += t[3];
+                    for (int c = 0; c < 3; c++)
+                        sum[c] += static_cast<uint32_t>(t[c]) * t[3];
+                }
+            }
+
+            const auto taps = static_cast<uint32_t>(rows * columns);
+            uint8_t* out = &dst.rgba[(static_cast<size_t>(y) * static_cast<size_t>(dst.width) + static_cast<size_t>(x)) * 4];
+            for (int c = 0; c < 3; c++)
+                out[c] = sumA > 0 ? static_cast<uint8_t>((sum[c] + sumA / 2) / sumA) : 0;
+            out[3] = static_cast<uint8_t>((sumA + taps / 2) / taps);
+        }
+    }
+}
+
+template <TextureLayout From, TextureLayout To>
+std::vector<uint8_t> Relayout(int width, int height, const std::vector<uint8_t>& src)
+{
+    std::vector<uint8_t> dst(GetTexelStorageCount(To, width, height) * 4, 0);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const uint8_t* s = &src[TexelIndex<From>(width, x, y) * 4];
+            uint8_t* d = &dst[TexelIndex<To>(width, x, y) * 4];
+            std::copy(s, s + 4, d);
+        }
+    }
+    return dst;
+}
+
+std::vector<uint8_t> Relayout(TextureLayout from, TextureLayout to, int width, int height, const std::vector<uint8_t>& src)
+{
+    if (from == TextureLayout::RowMajor && to == TextureLayout::Tiled4x4)
+        return Relayout<TextureLayout::RowMajor, TextureLayout::Tiled4x4>(width, height, src);
+    return Relayout<TextureLayout::Tiled4x4, TextureLayout::RowMajor>(width, height, src);
+}
+} // namespace
+
+void BuildMipChain(TextureRgba& texture)
+{
+    texture.mips.clear();
+    if (texture.width <= 0 || texture.height <= 0 || texture.rgba.empty())
+        return;
+
+    const TextureLayout layout = texture.layout;
+    SetTextureLayout(texture, TextureLayout::RowMajor);
+
+    size_t levels = 0;
+    for (int w = texture.width, h = texture.height; w > 1 || h > 1; w = std::max(1, w / 2), h = std::max(1, h / 2))
+        levels++;
+    texture.mips.reserve(levels);
+
+    TextureLevelView src = GetMipLevel(texture, 0);
+    while (src.width > 1 || src.height > 1)
+    {
+        texture.mips.emplace_back();
+        Downsample(src, texture.mips.back());
+        src = {texture.mips.back().width, texture.mips.back().height, texture.mips.back().rgba.data()};
+    }
+
+    SetTextureLayout(texture, layout);
+}
+
+void SetTextureLayout(TextureRgba& texture, TextureLayout layout)
+{
+    if (texture.layout == layout)
+        return;
+
+    texture.rgba = Relayout(texture.layout, layout, texture.width, texture.height, texture.rgba);
+    for (auto& mip : texture.mips)
+        mip.rgba = Relayout(texture.layout, layout, mip.width, mip.height, mip.rgba);
+    texture.layout = layout;
+}
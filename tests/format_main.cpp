@@ -0,0 +1,479 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/atlas.hpp"
+#include "CrossPlatformMdlExporter/gltf_exporter.hpp"
+#include "CrossPlatformMdlExporter/image_writer.hpp"
+#include "CrossPlatformMdlExporter/mdl_model.hpp"
+#include "CrossPlatformMdlExporter/mdl_types.hpp"
+#include "CrossPlatformMdlExporter/rasterizer.hpp"
+#include "synthetic_mdl.hpp"
+#include "test_support.hpp"
+
+// Encodes with the exporter, decodes with the independent readers in test_support.cpp and
+// requires the original pixels back; glb and atlas output are checked structurally.
+
+namespace
+{
+struct TestImage
+{
+    std::string name;
+    int width{};
+    int height{};
+    std::vector<uint8_t> rgba;
+};
+
+struct Context
+{
+    std::filesystem::path workDir;
+};
+
+bool Fail(const std::string& what)
+{
+    std::cerr << what << "\n";
+    return false;
+}
+
+// Odd sizes exercise the partial last scanline/run; the render has flat transparent runs and
+// antialiased edges, the noise defeats every predictor (and spans several encoder chunks),
+// and 1x1 is the smallest legal image.
+bool MakeImages(const Context& context, std::vector<TestImage>& images)
+{
+    const auto modelPath = context.workDir / "render.mdl";
+    SyntheticMdlOptions modelOptions;
+    modelOptions.maskedTextures = true;
+    StudioModelCpu model;
+    if (!WriteSyntheticMdl(modelPath, modelOptions) || !model.LoadFromFile(modelPath))
+        return Fail("generating the model failed");
+
+    TestImage render{"render", 131, 97, {}};
+    RenderOptions options{};
+    options.width = render.width;
+    options.height = render.height;
+    options.background = BackgroundPreset::Transparent;
+    options.lighting = true;
+    if (!RenderThumbnailRgba(model, options, render.rgba))
+        return Fail("render failed");
+    images.push_back(std::move(render));
+
+    TestImage noise{"noise", 181, 129, {}};
+    std::mt19937 rng(1234);
+    noise.rgba.resize(static_cast<size_t>(noise.width) * static_cast<size_t>(noise.height) * 4);
+    for (auto& b : noise.rgba)
+        b = static_cast<uint8_t>(rng() >> 24);
+    images.push_back(std::move(noise));
+
+    images.push_back({"single", 1, 1, {10, 200, 30, 128}});
+    return true;
+}
+
+bool CheckRoundTrip(const TestImage& image, const std::string& format, const std::vector<uint8_t>& encoded,
+                    const std::function<bool(int&, int&, std::vector<uint8_t>&)>& decode)
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> decoded;
+    const std::string label = format + " " + image.name + ": ";
+    if (!decode(width, height, decoded))
+        return Fail(label + "decoding failed");
+    if (width != image.width || height != image.height)
+        return Fail(label + "decoded " + std::to_string(width) + "x" + std::to_string(height) + ", expected " + std::to_string(image.width) + "x" + std::to_string(image.height));
+    const auto mismatch = std::mismatch(decoded.begin(), decoded.end(), image.rgba.begin());
+    if (mismatch.first != decoded.end())
+        return Fail(label + "byte " + std::to_string(mismatch.first - decoded.begin()) + " differs");
+    std::cout << label << encoded.size() << " bytes for " << image.rgba.size() << " raw\n";
+    return true;
+}
+
+bool CheckImageFormat(const Context& context, ImageFormat format, const ImageWriteOptions& options, const std::string& label)
+{
+    std::vector<TestImage> images;
+    if (!MakeImages(context, images))
+        return false;
+
+    bool ok = true;
+    for (const auto& image : images)
+    {
+        std::vector<uint8_t> encoded;
+        if (!EncodeImage(format, image.width, image.height, image.rgba, options, encoded))
+        {
+            ok = Fail(label + " " + image.name + ": encoding failed");
+            continue;
+        }
+        ok = CheckRoundTrip(image, label, encoded, [&](int& w, int& h, std::vector<uint8_t>& rgba) {
+                 if (format == ImageFormat::Png)
+                     return DecodePngRgba(encoded.data(), encoded.size(), w, h, rgba);
+                 if (format == ImageFormat::Qoi)
+                     return DecodeQoiRgba(encoded, w, h, rgba);
+                 return DecodeTgaRgba(encoded, w, h, rgba);
+             }) && ok;
+    }
+    return ok;
+}
+
+bool CheckPng(const Context& context, PngCompression compression, const std::string& label)
+{
+    ImageWriteOptions options;
+    options.pngCompression = compression;
+    return CheckImageFormat(context, ImageFormat::Png, options, label);
+}
+
+bool CheckTga(const Context& context, TgaCompression compression, const std::string& label)
+{
+    ImageWriteOptions options;
+    options.tgaCompression = compression;
+    return CheckImageFormat(context, ImageFormat::Tga, options, label);
+}
+
+uint32_t ReadU32Le(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+size_t JsonSize(const JsonValue* value)
+{
+    if (value == nullptr || value->type != JsonValue::Type::Number || value->number < 0.0 || value->number != std::floor(value->number))
+        return SIZE_MAX;
+    return static_cast<size_t>(value->number);
+}
+
+const JsonValue* JsonIndex(const JsonValue* array, size_t index)
+{
+    if (array == nullptr || array->type != JsonValue::Type::Array || index >= array->array.size())
+        return nullptr;
+    return &array->array[index];
+}
+
+struct BufferSlice
+{
+    const uint8_t* data{};
+    size_t size{};
+};
+
+// Resolves an accessor to its bytes and checks it fits its view and the view fits the buffer.
+bool ResolveAccessor(const JsonValue& gltf, size_t accessorIndex, const std::vector<uint8_t>& bin, size_t componentSize, size_t components, size_t& count,
+                     BufferSlice& slice)
+{
+    const JsonValue* accessor = JsonIndex(gltf.Find("accessors"), accessorIndex);
+    if (accessor == nullptr)
+        return Fail("glb: accessor " + std::to_string(accessorIndex) + " missing");
+    const JsonValue* view = JsonIndex(gltf.Find("bufferViews"), JsonSize(accessor->Find("bufferView")));
+    if (view == nullptr)
+        return Fail("glb: accessor " + std::to_string(accessorIndex) + " has no buffer view");
+    const size_t offset = JsonSize(view->Find("byteOffset"));
+    const size_t length = JsonSize(view->Find("byteLength"));
+    count = JsonSize(accessor->Find("count"));
+    if (offset == SIZE_MAX || length == SIZE_MAX || count == SIZE_MAX || offset % 4 != 0 || offset + length > bin.size())
+        return Fail("glb: buffer view of accessor " + std::to_string(accessorIndex) + " lies outside the BIN chunk");
+    if (count * componentSize * components > length)
+        return Fail("glb: accessor " + std::to_string(accessorIndex) + " is larger than its buffer view");
+    slice = {bin.data() + offset, length};
+    return true;
+}
+
+bool CheckGlb(const Context& context)
+{
+    const auto modelPath = context.workDir / "glb.mdl";
+    SyntheticMdlOptions modelOptions;
+    modelOptions.bodyParts = 2;
+    modelOptions.subModels = 2;
+    modelOptions.textures = 3;
+    modelOptions.textureWidth = 48;
+    modelOptions.textureHeight = 40;
+    modelOptions.maskedTextures = true;
+    modelOptions.lastTextureFlags = STUDIO_NF_ADDITIVE;
+    StudioModelCpu model;
+    if (!WriteSyntheticMdl(modelPath, modelOptions) || !model.LoadFromFile(modelPath))
+        return Fail("glb: generating the model failed");
+
+    GlbExportOptions options;
+    options.allSubmodels = true;
+    options.textureCompression = PngCompression::Fast;
+    std::ostringstream stream;
+    if (!WriteGlb(stream, model, options))
+        return Fail("glb: export failed");
+    const std::string text = stream.str();
+    const std::vector<uint8_t> file(text.begin(), text.end());
+
+    if (file.size() < 28 || std::memcmp(file.data(), "glTF", 4) != 0 || ReadU32Le(&file[4]) != 2 || ReadU32Le(&file[8]) != file.size())
+        return Fail("glb: bad header");
+    const size_t jsonLength = ReadU32Le(&file[12]);
+    if (std::memcmp(&file[16], "JSON", 4) != 0 || jsonLength % 4 != 0 || 20 + jsonLength + 8 > file.size())
+        return Fail("glb: bad JSON chunk");
+    const uint8_t* binHeader = &file[20 + jsonLength];
+    const size_t binLength = ReadU32Le(binHeader);
+    if (std::memcmp(binHeader + 4, "BIN\0", 4) != 0 || binLength % 4 != 0 || 20 + jsonLength + 8 + binLength != file.size())
+        return Fail("glb: bad BIN chunk");
+    const std::vector<uint8_t> bin(binHeader + 8, binHeader + 8 + binLength);
+
+    JsonValue gltf;
+    if (!ParseJson(std::string(text, 20, jsonLength), gltf) || gltf.type != JsonValue::Type::Object)
+        return Fail("glb: JSON chunk does not parse");
+    const JsonValue* asset = gltf.Find("asset");
+    const JsonValue* version = asset != nullptr ? asset->Find("version") : nullptr;
+    if (version == nullptr || version->string != "2.0")
+        return Fail("glb: asset.version is not 2.0");
+    const JsonValue* buffer = JsonIndex(gltf.Find("buffers"), 0);
+    if (buffer == nullptr || JsonSize(buffer->Find("byteLength")) != binLength)
+        return Fail("glb: buffers[0].byteLength does not match the BIN chunk");
+
+    // Nodes are emitted per body part and submodel, skipping empty ones; the synthetic model has none.
+    const ModelGeometry& geometry = model.GetGeometry();
+    std::vector<const Model*> submodels;
+    for (const auto& bodyPart : geometry.bodyParts)
+    {
+        for (const auto& m : geometry.Models(bodyPart))
+            submodels.push_back(&m);
+    }
+    const JsonValue* meshes = gltf.Find("meshes");
+    if (meshes == nullptr || meshes->array.size() != submodels.size())
+        return Fail("glb: expected one mesh per submodel");
+
+    for (size_t s = 0; s < submodels.size(); s++)
+    {
+        const auto vertices = geometry.Vertices(*submodels[s]);
+        const auto studioMeshes = geometry.Meshes(*submodels[s]);
+        const JsonValue* primitives = meshes->array[s].Find("primitives");
+        if (primitives == nullptr || primitives->array.size() != studioMeshes.size())
+            return Fail("glb: mesh " + std::to_string(s) + " should have one primitive per studio mesh");
+
+        for (size_t p = 0; p < studioMeshes.size(); p++)
+        {
+            const JsonValue& primitive = primitives->array[p];
+            const JsonValue* attributes = primitive.Find("attributes");
+            if (attributes == nullptr)
+                return Fail("glb: primitive without attributes");
+
+            size_t count = 0;
+            BufferSlice positions;
+            if (!ResolveAccessor(gltf, JsonSize(attributes->Find("POSITION")), bin, 4, 3, count, positions))
+                return false;
+            if (count != vertices.size())
+                return Fail("glb: POSITION count differs from the submodel's vertex count");
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                float xyz[3];
+                std::memcpy(xyz, positions.data + v * 12, 12);
+                // Z-up to Y-up: (x, y, z) -> (y, z, x).
+                if (xyz[0] != vertices[v].position.y || xyz[1] != vertices[v].position.z || xyz[2] != vertices[v].position.x)
+                    return Fail("glb: position " + std::to_string(v) + " of mesh " + std::to_string(s) + " differs");
+            }
+            BufferSlice unused;
+            if (!ResolveAccessor(gltf, JsonSize(attributes->Find("NORMAL")), bin, 4, 3, count, unused) ||
+                !ResolveAccessor(gltf, JsonSize(attributes->Find("TEXCOORD_0")), bin, 4, 2, count, unused))
+                return false;
+
+            const size_t accessorIndex = JsonSize(primitive.Find("indices"));
+            const JsonValue* accessor = JsonIndex(gltf.Find("accessors"), accessorIndex);
+            const size_t componentType = accessor != nullptr ? JsonSize(accessor->Find("componentType")) : 0;
+            if (componentType != 5123 && componentType != 5125)
+                return Fail("glb: indices must be unsigned short or unsigned int");
+            const size_t indexSize = componentType == 5123 ? 2 : 4;
+            BufferSlice indexData;
+            if (!ResolveAccessor(gltf, accessorIndex, bin, indexSize, 1, count, indexData))
+                return false;
+
+            const auto indices = geometry.Indices(studioMeshes[p]);
+            if (count != indices.size() / 3 * 3)
+                return Fail("glb: index count differs from the studio mesh");
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t index = 0;
+                std::memcpy(&index, indexData.data + i * indexSize, indexSize);
+                // Winding flips from clockwise to counter-clockwise: (a, b, c) -> (a, c, b).
+                const size_t corner = i % 3;
+                const uint32_t expected = indices[i - corner + (corner == 0 ? 0 : 3 - corner)];
+                if (index != expected || index >= vertices.size())
+                    return Fail("glb: index " + std::to_string(i) + " of primitive " + std::to_string(p) + " differs");
+            }
+        }
+    }
+
+    const auto& textures = model.GetTextures();
+    const JsonValue* images = gltf.Find("images");
+    if (images == nullptr || images->array.size() != textures.size())
+        return Fail("glb: expected one image per texture");
+    for (size_t t = 0; t < textures.size(); t++)
+    {
+        const JsonValue* view = JsonIndex(gltf.Find("bufferViews"), JsonSize(images->array[t].Find("bufferView")));
+        const size_t offset = view != nullptr ? JsonSize(view->Find("byteOffset")) : SIZE_MAX;
+        const size_t length = view != nullptr ? JsonSize(view->Find("byteLength")) : SIZE_MAX;
+        if (offset == SIZE_MAX || length == SIZE_MAX || offset % 4 != 0 || offset + length > bin.size())
+            return Fail("glb: image " + std::to_string(t) + " lies outside the BIN chunk");
+
+        const TestImage expected{"texture" + std::to_string(t), textures[t].width, textures[t].height, textures[t].rgba};
+        if (!CheckRoundTrip(expected, "glb", {bin.begin() + static_cast<ptrdiff_t>(offset), bin.begin() + static_cast<ptrdiff_t>(offset + length)},
+                            [&](int& w, int& h, std::vector<uint8_t>& rgba) { return DecodePngRgba(bin.data() + offset, length, w, h, rgba); }))
+            return false;
+    }
+    return true;
+}
+
+bool CheckAtlas(const Context& context)
+{
+    SyntheticMdlOptions first;
+    first.textures = 3;
+    first.textureWidth = 64;
+    first.textureHeight = 32;
+    SyntheticMdlOptions second;
+    second.textures = 2;
+    second.textureWidth = 24;
+    second.textureHeight = 56;
+    second.maskedTextures = true;
+
+    StudioModelCpu models[2];
+    const SyntheticMdlOptions* options[2] = {&first, &second};
+    std::vector<const StudioModelCpu*> sources;
+    for (size_t i = 0; i < 2; i++)
+    {
+        const auto modelPath = context.workDir / ("atlas" + std::to_string(i) + ".mdl");
+        if (!WriteSyntheticMdl(modelPath, *options[i]) || !models[i].LoadFromFile(modelPath))
+            return Fail("atlas: generating the models failed");
+        sources.push_back(&models[i]);
+    }
+
+    AtlasOptions atlasOptions;
+    atlasOptions.padding = 3;
+    TextureAtlas atlas;
+    if (!BuildTextureAtlas(sources, atlasOptions, atlas))
+        return Fail("atlas: packing failed");
+    if (atlas.rects.size() != static_cast<size_t>(first.textures + second.textures) || atlas.rgba.size() != static_cast<size_t>(atlas.width) * static_cast<size_t>(atlas.height) * 4)
+        return Fail("atlas: wrong number of rects or wrong image size");
+
+    const int pad = atlas.padding;
+    for (size_t i = 0; i < atlas.rects.size(); i++)
+    {
+        const AtlasRect& r = atlas.rects[i];
+        const TextureRgba& texture = sources[static_cast<size_t>(r.source)]->GetTextures()[static_cast<size_t>(r.texture)];
+        const std::string label = "atlas: rect " + std::to_string(i) + " ";
+        if (r.width != texture.width || r.height != texture.height)
+            return Fail(label + "does not match its texture size");
+        if (r.x - pad < 0 || r.y - pad < 0 || r.x + r.width + pad > atlas.width || r.y + r.height + pad > atlas.height)
+            return Fail(label + "lies outside the atlas");
+        for (size_t j = 0; j < i; j++)
+        {
+            const AtlasRect& o = atlas.rects[j];
+            if (r.x - pad < o.x + o.width + pad && o.x - pad < r.x + r.width + pad && r.y - pad < o.y + o.height + pad && o.y - pad < r.y + r.height + pad)
+                return Fail(label + "overlaps rect " + std::to_string(j));
+        }
+
+        // Every texel, padding included, is the nearest texel of the source texture.
+        for (int y = -pad; y < r.height + pad; y++)
+        {
+            const int sy = std::clamp(y, 0, r.height - 1);
+            for (int x = -pad; x < r.width + pad; x++)
+            {
+                const int sx = std::clamp(x, 0, r.width - 1);
+                const uint8_t* got = &atlas.rgba[(static_cast<size_t>(r.y + y) * static_cast<size_t>(atlas.width) + static_cast<size_t>(r.x + x)) * 4];
+                const uint8_t* want = &texture.rgba[(static_cast<size_t>(sy) * static_cast<size_t>(texture.width) + static_cast<size_t>(sx)) * 4];
+                if (std::memcmp(got, want, 4) != 0)
+                    return Fail(label + "texel " + std::to_string(x) + "," + std::to_string(y) + " differs");
+            }
+        }
+    }
+
+    std::ostringstream json;
+    WriteAtlasJson(json, atlas, sources);
+    JsonValue root;
+    if (!ParseJson(json.str(), root) || root.type != JsonValue::Type::Object)
+        return Fail("atlas: JSON does not parse");
+    const JsonValue* rects = root.Find("textures");
+    if (JsonSize(root.Find("width")) != static_cast<size_t>(atlas.width) || JsonSize(root.Find("height")) != static_cast<size_t>(atlas.height) ||
+        JsonSize(root.Find("padding")) != static_cast<size_t>(pad) || rects == nullptr || rects->array.size() != atlas.rects.size())
+        return Fail("atlas: JSON header differs from the atlas");
+    for (size_t i = 0; i < atlas.rects.size(); i++)
+    {
+        const JsonValue& entry = rects->array[i];
+        const AtlasRect& r = atlas.rects[i];
+        const JsonValue* scale = entry.Find("uvScale");
+        const JsonValue* offset = entry.Find("uvOffset");
+        if (JsonSize(entry.Find("source")) != static_cast<size_t>(r.source) || JsonSize(entry.Find("texture")) != static_cast<size_t>(r.texture) ||
+            JsonSize(entry.Find("x")) != static_cast<size_t>(r.x) || JsonSize(entry.Find("y")) != static_cast<size_t>(r.y) ||
+            JsonSize(entry.Find("w")) != static_cast<size_t>(r.width) || JsonSize(entry.Find("h")) != static_cast<size_t>(r.height))
+            return Fail("atlas: JSON entry " + std::to_string(i) + " differs from the rect");
+        if (scale == nullptr || scale->array.size() != 2 || offset == nullptr || offset->array.size() != 2 ||
+            std::abs(scale->array[0].number * atlas.width - r.width) > 1e-3 || std::abs(scale->array[1].number * atlas.height - r.height) > 1e-3 ||
+            std::abs(offset->array[0].number * atlas.width - r.x) > 1e-3 || std::abs(offset->array[1].number * atlas.height - r.y) > 1e-3)
+            return Fail("atlas: uv transform of JSON entry " + std::to_string(i) + " does not map onto the rect");
+    }
+    std::cout << "atlas: " << atlas.rects.size() << " textures in " << atlas.width << "x" << atlas.height << "\n";
+    return true;
+}
+
+struct FormatCase
+{
+    const char* name;
+    std::function<bool(const Context&)> run;
+};
+
+std::vector<FormatCase> MakeCases()
+{
+    return {
+        {"png_stored", [](const Context& c) { return CheckPng(c, PngCompression::Stored, "png_stored"); }},
+        {"png_fast", [](const Context& c) { return CheckPng(c, PngCompression::Fast, "png_fast"); }},
+        {"png_best", [](const Context& c) { return CheckPng(c, PngCompression::Best, "png_best"); }},
+        {"qoi", [](const Context& c) { return CheckImageFormat(c, ImageFormat::Qoi, {}, "qoi"); }},
+        {"tga", [](const Context& c) { return CheckTga(c, TgaCompression::None, "tga"); }},
+        {"tga_rle", [](const Context& c) { return CheckTga(c, TgaCompression::Rle, "tga_rle"); }},
+        {"glb", CheckGlb},
+        {"atlas", CheckAtlas},
+    };
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string caseName;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--case" && i + 1 < argc)
+        {
+            caseName = argv[++i];
+            continue;
+        }
+        std::cerr << "Usage: CrossPlatformMdlExporterFormats [--case NAME]\n";
+        return 2;
+    }
+
+    std::vector<FormatCase> cases;
+    for (const auto& c : MakeCases())
+    {
+        if (caseName.empty() || c.name == caseName)
+            cases.push_back(c);
+    }
+    if (cases.empty())
+    {
+        std::cerr << "Unknown case: " << caseName << "\n";
+        return 2;
+    }
+
+    std::error_code ec;
+    Context context;
+    context.workDir = std::filesystem::temp_directory_path(ec) / ("cpme_formats_" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directories(context.workDir, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot create work directory: " << context.workDir.string() << "\n";
+        return 1;
+    }
+
+    int result = 0;
+    for (const auto& c : cases)
+    {
+        if (!c.run(context))
+        {
+            std::cerr << c.name << ": FAILED\n";
+            result = 1;
+        }
+    }
+
+    std::filesystem::remove_all(context.workDir, ec);
+    return result;
+}
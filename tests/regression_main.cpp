@@ -0,0 +1,646 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CrossPlatformMdlExporter/image_writer.hpp"
+#include "CrossPlatformMdlExporter/mdl_model.hpp"
+#include "CrossPlatformMdlExporter/mdl_types.hpp"
+#include "CrossPlatformMdlExporter/profiler.hpp"
+#include "CrossPlatformMdlExporter/rasterizer.hpp"
+#include "synthetic_mdl.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+// CTest treats this exit code as "skipped" (SKIP_RETURN_CODE in tests/CMakeLists.txt).
+constexpr int kSkipped = 77;
+// Added to every budget so sub-millisecond timings don't fail on scheduler noise.
+constexpr double kTimingSlackMs = 0.5;
+
+struct RegressionCase
+{
+    std::string name;
+    SyntheticMdlOptions model;
+    LoadOptions load;
+    RenderOptions render;
+    // Render through RenderContext::RenderBanded with bands this tall; 0 renders in one pass.
+    int bandRows{};
+    // Also render with ShadingMode::Forward and require exactly the same pixels.
+    bool matchForward{false};
+};
+
+SyntheticMdlOptions MediumModel()
+{
+    SyntheticMdlOptions options;
+    options.bones = 16;
+    options.bodyParts = 2;
+    options.subModels = 2;
+    options.meshesPerModel = 4;
+    options.rings = 32;
+    options.segments = 48;
+    options.fanRatio = 0.5f;
+    options.textures = 4;
+    options.textureWidth = 256;
+    options.textureHeight = 256;
+    return options;
+}
+
+// Keep in sync with the case list in tests/CMakeLists.txt.
+std::vector<RegressionCase> MakeCases()
+{
+    std::vector<RegressionCase> cases;
+    RenderOptions thumbnail{};
+    thumbnail.width = 128;
+    thumbnail.height = 128;
+
+    RegressionCase small{"small_forward", {}, {}, thumbnail};
+    cases.push_back(small);
+
+    RegressionCase lit{"small_lit_yaw", {}, {}, thumbnail};
+    lit.render.lighting = true;
+    lit.render.yawDegrees = 45.0f;
+    lit.render.textureFilter = TextureFilter::Bilinear;
+    cases.push_back(lit);
+
+    RegressionCase masked{"split_masked", {}, {}, thumbnail};
+    masked.model.maskedTextures = true;
+    masked.model.separateTextureFile = true;
+    masked.render.background = BackgroundPreset::Transparent;
+    masked.render.lighting = true;
+    cases.push_back(masked);
+
+    RegressionCase chrome{"chrome_lit", {}, {}, thumbnail};
+    chrome.model.lastTextureFlags = STUDIO_NF_CHROME;
+    chrome.render.lighting = true;
+    cases.push_back(chrome);
+
+    RegressionCase additive{"additive", {}, {}, thumbnail};
+    additive.model.lastTextureFlags = STUDIO_NF_ADDITIVE;
+    additive.render.background = BackgroundPreset::Green;
+    cases.push_back(additive);
+
+    RegressionCase visibility{"medium_visibility", MediumModel(), {}, thumbnail};
+    visibility.render.width = 192;
+    visibility.render.height = 192;
+    visibility.render.shadingMode = ShadingMode::Visibility;
+    visibility.render.textureFilter = TextureFilter::Trilinear;
+    cases.push_back(visibility);
+
+    RegressionCase tiled{"medium_tiled_optimized", MediumModel(), {}, thumbnail};
+    tiled.load.textureLayout = TextureLayout::Tiled4x4;
+    tiled.load.optimizeVertexCache = true;
+    tiled.render.textureFilter = TextureFilter::NearestMip;
+    tiled.render.lighting = true;
+    cases.push_back(tiled);
+
+    RegressionCase banded{"medium_banded", MediumModel(), {}, thumbnail};
+    banded.render.width = 192;
+    banded.render.height = 160;
+    banded.render.yawDegrees = 120.0f;
+    banded.bandRows = 24;
+    cases.push_back(banded);
+
+    RegressionCase maskedVisibility{"masked_visibility", MediumModel(), {}, thumbnail};
+    maskedVisibility.model.maskedTextures = true;
+    maskedVisibility.render.width = 192;
+    maskedVisibility.render.height = 192;
+    maskedVisibility.render.background = BackgroundPreset::Transparent;
+    maskedVisibility.render.shadingMode = ShadingMode::Visibility;
+    maskedVisibility.render.textureFilter = TextureFilter::Trilinear;
+    maskedVisibility.matchForward = true;
+    cases.push_back(maskedVisibility);
+
+    // Odd texture sizes fold the last row and column into the smaller mip levels.
+    RegressionCase oddMips{"odd_texture_mips", {}, {}, thumbnail};
+    oddMips.model.textureWidth = 45;
+    oddMips.model.textureHeight = 27;
+    oddMips.render.width = 48;
+    oddMips.render.height = 48;
+    oddMips.render.textureFilter = TextureFilter::Trilinear;
+    cases.push_back(oddMips);
+
+    RegressionCase draft{"medium_draft", MediumModel(), {}, thumbnail};
+    draft.load.skipTextures = true;
+    draft.render.quality = RenderQuality::Draft;
+    draft.render.yawDegrees = 30.0f;
+    cases.push_back(draft);
+
+    return cases;
+}
+
+struct Settings
+{
+    std::string caseName;
+    std::filesystem::path goldenDir;
+    std::filesystem::path baselinePath;
+    std::filesystem::path workPath;
+    bool timing{false};
+    bool update{false};
+    // Largest per-channel difference that still counts as a matching pixel, and the
+    // fraction of pixels allowed beyond it (edge coverage may flip with FMA contraction).
+    int pixelTolerance{2};
+    double maxBadPixels{0.002};
+    // A timing passes while median <= baseline * machine factor * timeTolerance + kTimingSlackMs.
+    double timeTolerance{3.0};
+    // A work count passes while count <= baseline * (1 + workTolerance); the slack absorbs
+    // edge pixels that flip with FMA contraction.
+    double workTolerance{0.02};
+    double minSeconds{0.25};
+    size_t minIterations{3};
+};
+
+bool Render(const StudioModelCpu& model, const RegressionCase& c, std::vector<uint8_t>& rgba, RenderStats* stats = nullptr, Profiler* profiler = nullptr)
+{
+    if (c.bandRows <= 0)
+        return RenderThumbnailRgba(model, c.render, rgba, stats, profiler);
+
+    RenderContext context;
+    rgba.assign(static_cast<size_t>(c.render.width) * static_cast<size_t>(c.render.height) * 4, 0);
+    return context.RenderBanded(model, c.render, c.bandRows, [&](int y, int rows, const uint8_t* band) {
+        std::copy(band, band + static_cast<size_t>(rows) * static_cast<size_t>(c.render.width) * 4, rgba.begin() + static_cast<ptrdiff_t>(static_cast<size_t>(y) * static_cast<size_t>(c.render.width) * 4));
+        return true;
+    }, stats, profiler);
+}
+
+int CompareToGolden(const RegressionCase& c, const std::vector<uint8_t>& rgba, const Settings& settings)
+{
+    const auto goldenPath = settings.goldenDir / (c.name + ".tga");
+    if (settings.update)
+    {
+        if (!WriteTgaRgba(goldenPath, c.render.width, c.render.height, rgba, TgaCompression::Rle))
+        {
+            std::cerr << c.name << ": writing " << goldenPath.string() << " failed\n";
+            return 1;
+        }
+        std::cout << c.name << ": updated " << goldenPath.string() << "\n";
+        return 0;
+    }
+
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> golden;
+    if (!ReadTgaRgba(goldenPath, width, height, golden))
+    {
+        std::cerr << c.name << ": cannot read golden image " << goldenPath.string() << "\n";
+        return 1;
+    }
+    if (width != c.render.width || height != c.render.height)
+    {
+        std::cerr << c.name << ": golden image is " << width << "x" << height << ", render is " << c.render.width << "x" << c.render.height << "\n";
+        return 1;
+    }
+
+    size_t badPixels = 0;
+    int maxDiff = 0;
+    for (size_t i = 0; i < golden.size(); i += 4)
+    {
+        int diff = 0;
+        for (size_t ch = 0; ch < 4; ch++)
+            diff = std::max(diff, std::abs(static_cast<int>(golden[i + ch]) - static_cast<int>(rgba[i + ch])));
+        maxDiff = std::max(maxDiff, diff);
+        if (diff > settings.pixelTolerance)
+            badPixels++;
+    }
+
+    const size_t pixels = golden.size() / 4;
+    const auto allowed = static_cast<size_t>(settings.maxBadPixels * static_cast<double>(pixels));
+    std::cout << c.name << ": " << badPixels << " of " << pixels << " pixels differ by more than " << settings.pixelTolerance << " (allowed " << allowed
+              << "), max difference " << maxDiff << "\n";
+    if (badPixels <= allowed)
+        return 0;
+
+    const auto actualPath = std::filesystem::path(c.name + ".actual.tga");
+    if (WriteTgaRgba(actualPath, c.render.width, c.render.height, rgba))
+        std::cerr << c.name << ": render written to " << std::filesystem::absolute(actualPath).string() << "\n";
+    return 1;
+}
+
+// Visibility shading must not change the image, only the work done to produce it.
+int CompareToForward(const StudioModelCpu& model, const RegressionCase& c, const std::vector<uint8_t>& rgba)
+{
+    RegressionCase forward = c;
+    forward.render.shadingMode = ShadingMode::Forward;
+    std::vector<uint8_t> expected;
+    if (!Render(model, forward, expected) || expected.size() != rgba.size())
+    {
+        std::cerr << c.name << ": forward render failed\n";
+        return 1;
+    }
+
+    size_t differing = 0;
+    for (size_t i = 0; i < rgba.size(); i += 4)
+    {
+        if (!std::equal(rgba.begin() + static_cast<ptrdiff_t>(i), rgba.begin() + static_cast<ptrdiff_t>(i + 4), expected.begin() + static_cast<ptrdiff_t>(i)))
+            differing++;
+    }
+    std::cout << c.name << ": " << differing << " pixels differ from the forward render\n";
+    return differing == 0 ? 0 : 1;
+}
+
+// Runs fn once to warm up, then until both minIterations and minSeconds are reached, and
+// returns the median in milliseconds (negative if fn failed).
+double MedianMs(const Settings& settings, const std::function<bool()>& fn)
+{
+    if (!fn())
+        return -1.0;
+
+    std::vector<double> samples;
+    const auto start = std::chrono::steady_clock::now();
+    while (samples.size() < settings.minIterations || std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < settings.minSeconds)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Fixed scalar float and integer workload timed next to every baseline. The ratio of its
+// time here to its time in the baseline file scales the budgets to the current machine.
+double MeasureCalibrationMs(const Settings& settings)
+{
+    std::vector<float> data(1 << 16);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<float>(i % 251) * 0.01f;
+
+    volatile float sink = 0.0f;
+    return MedianMs(settings, [&]() {
+        float x = 0.0f;
+        uint32_t h = 2166136261u;
+        for (int pass = 0; pass < 64; pass++)
+        {
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                x = x * 0.999f + data[i];
+                h = (h ^ static_cast<uint32_t>(x)) * 16777619u;
+                data[i] = x * 0.5f + static_cast<float>(h & 7);
+            }
+        }
+        sink = x;
+        return true;
+    });
+}
+
+// "name milliseconds" per line; '#' starts a comment line.
+bool ReadBaseline(const std::filesystem::path& filePath, std::map<std::string, double>& baseline)
+{
+    std::ifstream in(filePath);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        const size_t space = line.find(' ');
+        if (space == std::string::npos)
+            return false;
+        baseline[line.substr(0, space)] = std::atof(line.c_str() + space + 1);
+    }
+    return true;
+}
+
+bool WriteBaseline(const std::filesystem::path& filePath, const char* description, int decimals, const std::map<std::string, double>& baseline)
+{
+    std::ofstream out(filePath);
+    out << "# " << description << "\n"
+        << "# Regenerate with: cmake --build <build> --target regression-update\n";
+    for (const auto& [name, value] : baseline)
+    {
+        char line[128]{};
+        std::snprintf(line, sizeof(line), "%s %.*f\n", name.c_str(), decimals, value);
+        out << line;
+    }
+    return static_cast<bool>(out);
+}
+
+int CheckTiming(const RegressionCase& c, const std::filesystem::path& modelPath, const Settings& settings, double machineFactor, std::map<std::string, double>& baseline)
+{
+    std::vector<uint8_t> rgba;
+    StudioModelCpu model;
+    if (!model.LoadFromFile(modelPath, c.load))
+        return 1;
+
+    const std::pair<std::string, double> timings[] = {
+        {c.name + "/load", MedianMs(settings, [&]() {
+             StudioModelCpu fresh;
+             return fresh.LoadFromFile(modelPath, c.load);
+         })},
+        {c.name + "/render", MedianMs(settings, [&]() { return Render(model, c, rgba); })},
+    };
+
+    int result = 0;
+    for (const auto& [name, ms] : timings)
+    {
+        if (ms < 0.0)
+        {
+            std::cerr << name << ": FAILED\n";
+            result = 1;
+            continue;
+        }
+        if (settings.update)
+        {
+            baseline[name] = ms;
+            std::cout << name << ": " << ms << " ms\n";
+            continue;
+        }
+
+        const auto it = baseline.find(name);
+        if (it == baseline.end())
+        {
+            std::cerr << name << ": no baseline in " << settings.baselinePath.string() << "\n";
+            result = 1;
+            continue;
+        }
+        const double budget = it->second * machineFactor * settings.timeTolerance + kTimingSlackMs;
+        std::cout << name << ": " << ms << " ms, baseline " << it->second << " ms, budget " << budget << " ms\n";
+        if (ms > budget)
+        {
+            std::cerr << name << ": over budget\n";
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// Machine-independent cost of a case: the item count of every profiler stage a load plus a
+// render touched (bytes read, texels decoded, vertices, triangles, pixels) and the pixels
+// the render shaded and wrote.
+bool CountWork(const RegressionCase& c, const std::filesystem::path& modelPath, std::map<std::string, double>& counts)
+{
+    Profiler profiler;
+    StudioModelCpu model;
+    RenderStats stats{};
+    std::vector<uint8_t> rgba;
+    if (!model.LoadFromFile(modelPath, c.load, &profiler) || !Render(model, c, rgba, &stats, &profiler))
+        return false;
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(ProfileStage::Count); i++)
+    {
+        const auto stage = static_cast<ProfileStage>(i);
+        const auto totals = profiler.Get(stage);
+        if (totals.calls != 0)
+            counts[c.name + "/" + GetProfileStageName(stage)] = static_cast<double>(totals.items);
+    }
+    counts[c.name + "/pixels_shaded"] = static_cast<double>(stats.pixelsShaded);
+    counts[c.name + "/pixels_written"] = static_cast<double>(stats.pixelsWritten);
+    return true;
+}
+
+int CheckWork(const RegressionCase& c, const std::filesystem::path& modelPath, const Settings& settings, std::map<std::string, double>& baseline)
+{
+    std::map<std::string, double> counts;
+    if (!CountWork(c, modelPath, counts))
+    {
+        std::cerr << c.name << ": load or render failed\n";
+        return 1;
+    }
+
+    int result = 0;
+    for (const auto& [name, count] : counts)
+    {
+        if (settings.update)
+        {
+            baseline[name] = count;
+            continue;
+        }
+
+        const auto it = baseline.find(name);
+        if (it == baseline.end())
+        {
+            std::cerr << name << ": no baseline in " << settings.workPath.string() << "\n";
+            result = 1;
+            continue;
+        }
+        const double budget = std::floor(it->second * (1.0 + settings.workTolerance));
+        std::cout << name << ": " << count << ", baseline " << it->second << ", budget " << budget << "\n";
+        if (count > budget)
+        {
+            std::cerr << name << ": over budget\n";
+            result = 1;
+        }
+    }
+    return result;
+}
+
+bool TryParseDouble(const std::string& s, double& out)
+{
+    try
+    {
+        size_t pos = 0;
+        const double v = std::stod(s, &pos);
+        if (pos != s.size())
+            return false;
+        out = v;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        double value = 0.0;
+        if (arg == "--timing")
+        {
+            settings.timing = true;
+            continue;
+        }
+        if (arg == "--update")
+        {
+            settings.update = true;
+            continue;
+        }
+        if (arg == "--case" && i + 1 < argc)
+        {
+            settings.caseName = argv[++i];
+            continue;
+        }
+        if (arg == "--golden-dir" && i + 1 < argc)
+        {
+            settings.goldenDir = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        if (arg == "--baseline" && i + 1 < argc)
+        {
+            settings.baselinePath = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        if (arg == "--work" && i + 1 < argc)
+        {
+            settings.workPath = std::filesystem::u8path(argv[++i]);
+            continue;
+        }
+        if (arg == "--work-tolerance" && i + 1 < argc && TryParseDouble(argv[i + 1], value) && value >= 0.0)
+        {
+            settings.workTolerance = value;
+            i++;
+            continue;
+        }
+        if (arg == "--pixel-tolerance" && i + 1 < argc && TryParseDouble(argv[i + 1], value) && value >= 0.0)
+        {
+            settings.pixelTolerance = static_cast<int>(value);
+            i++;
+            continue;
+        }
+        if (arg == "--max-bad-pixels" && i + 1 < argc && TryParseDouble(argv[i + 1], value) && value >= 0.0)
+        {
+            settings.maxBadPixels = value;
+            i++;
+            continue;
+        }
+        if (arg == "--time-tolerance" && i + 1 < argc && TryParseDouble(argv[i + 1], value) && value >= 0.0)
+        {
+            settings.timeTolerance = value;
+            i++;
+            continue;
+        }
+        std::cerr << "Usage: CrossPlatformMdlExporterRegression [--case NAME] [--golden-dir DIR] [--timing --baseline FILE [--time-tolerance X]] [--pixel-tolerance N]\n"
+                     "                                          [--max-bad-pixels FRACTION] [--work FILE [--work-tolerance X]] [--update]\n";
+        return 2;
+    }
+
+    const bool checkImages = !settings.goldenDir.empty();
+    const bool checkWork = !settings.workPath.empty();
+    if (!checkImages && !checkWork && !settings.timing)
+    {
+        std::cerr << "Nothing to do: pass --golden-dir, --work and/or --timing\n";
+        return 2;
+    }
+    if (settings.timing && settings.baselinePath.empty())
+    {
+        std::cerr << "--timing needs --baseline\n";
+        return 2;
+    }
+
+    std::vector<RegressionCase> cases;
+    for (const auto& c : MakeCases())
+    {
+        if (settings.caseName.empty() || c.name == settings.caseName)
+            cases.push_back(c);
+    }
+    if (cases.empty())
+    {
+        std::cerr << "Unknown case: " << settings.caseName << "\n";
+        return 2;
+    }
+
+    if (settings.timing && !settings.update)
+    {
+#ifndef NDEBUG
+        std::cout << "Timing budgets apply to optimised builds only; skipped\n";
+        return kSkipped;
+#else
+        if (settings.timeTolerance <= 0.0)
+        {
+            std::cout << "Timing checks disabled (tolerance 0); skipped\n";
+            return kSkipped;
+        }
+#endif
+    }
+
+    std::map<std::string, double> baseline;
+    double machineFactor = 1.0;
+    if (settings.timing)
+    {
+        if (!ReadBaseline(settings.baselinePath, baseline) && !settings.update)
+        {
+            std::cerr << "Cannot read timing baseline " << settings.baselinePath.string() << "\n";
+            return 1;
+        }
+        const double calibrationMs = MeasureCalibrationMs(settings);
+        if (settings.update)
+        {
+            baseline["calibration"] = calibrationMs;
+        }
+        else if (baseline.count("calibration") != 0 && baseline["calibration"] > 0.0)
+        {
+            machineFactor = calibrationMs / baseline["calibration"];
+            std::cout << "calibration: " << calibrationMs << " ms, baseline " << baseline["calibration"] << " ms, machine factor " << machineFactor << "\n";
+        }
+    }
+
+    std::map<std::string, double> workBaseline;
+    if (checkWork && !ReadBaseline(settings.workPath, workBaseline) && !settings.update)
+    {
+        std::cerr << "Cannot read work baseline " << settings.workPath.string() << "\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    const auto workDir = std::filesystem::temp_directory_path(ec) / ("cpme_regression_" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directories(workDir, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot create work directory: " << workDir.string() << "\n";
+        return 1;
+    }
+
+    int result = 0;
+    for (const auto& c : cases)
+    {
+        const auto modelPath = workDir / (c.name + ".mdl");
+        if (!WriteSyntheticMdl(modelPath, c.model))
+        {
+            std::cerr << c.name << ": generating the model failed\n";
+            result = 1;
+            continue;
+        }
+
+        if (checkImages)
+        {
+            StudioModelCpu model;
+            std::vector<uint8_t> rgba;
+            if (!model.LoadFromFile(modelPath, c.load) || !Render(model, c, rgba))
+            {
+                std::cerr << c.name << ": load or render failed\n";
+                result = 1;
+                continue;
+            }
+            if (CompareToGolden(c, rgba, settings) != 0)
+                result = 1;
+            if (c.matchForward && CompareToForward(model, c, rgba) != 0)
+                result = 1;
+        }
+
+        if (checkWork && CheckWork(c, modelPath, settings, workBaseline) != 0)
+            result = 1;
+        if (settings.timing && CheckTiming(c, modelPath, settings, machineFactor, baseline) != 0)
+            result = 1;
+    }
+
+    // Partial updates (--case) keep the other cases' baselines.
+    if (settings.timing && settings.update &&
+        !WriteBaseline(settings.baselinePath, "Median milliseconds of tests/regression_main.cpp timings on one machine, Release build.", 4, baseline))
+    {
+        std::cerr << "Writing " << settings.baselinePath.string() << " failed\n";
+        result = 1;
+    }
+    if (checkWork && settings.update && !WriteBaseline(settings.workPath, "Profiler item counts and shaded/written pixels per case; machine-independent.", 0, workBaseline))
+    {
+        std::cerr << "Writing " << settings.workPath.string() << " failed\n";
+        result = 1;
+    }
+
+    std::filesystem::remove_all(workDir, ec);
+    return result;
+}
@@ -0,0 +1,713 @@
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+uint32_t ReadU32Be(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// Bitwise, table-free: slow but obviously correct.
+uint32_t Crc32(const uint8_t* data, size_t size)
+{
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+    }
+    return crc ^ 0xffffffffu;
+}
+
+uint32_t Adler32(const uint8_t* data, size_t size)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        a = (a + data[i]) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    return (b << 16) | a;
+}
+
+struct BitReader
+{
+    const uint8_t* data{};
+    size_t size{};
+    size_t pos{};
+    uint32_t buffer{};
+    int count{};
+    bool failed{false};
+
+    uint32_t Bits(int n)
+    {
+        while (count < n)
+        {
+            if (pos >= size)
+            {
+                failed = true;
+                return 0;
+            }
+            buffer |= static_cast<uint32_t>(data[pos++]) << count;
+            count += 8;
+        }
+        const uint32_t value = buffer & ((1u << n) - 1u);
+        buffer >>= n;
+        count -= n;
+        return value;
+    }
+
+    // Drops the rest of the current byte.
+    void Align()
+    {
+        buffer = 0;
+        count = 0;
+    }
+};
+
+// Canonical Huffman decoding table: code count per length and symbols in code order.
+struct Huffman
+{
+    std::array<uint16_t, 16> counts{};
+    std::vector<uint16_t> symbols;
+};
+
+bool BuildHuffman(Huffman& h, const uint8_t* lengths, int n)
+{
+    h.counts.fill(0);
+    for (int i = 0; i < n; i++)
+        h.counts[lengths[i]]++;
+    h.counts[0] = 0;
+
+    int left = 1;
+    for (int len = 1; len < 16; len++)
+    {
+        left = (left << 1) - h.counts[len];
+        if (left < 0)
+            return false;
+    }
+
+    std::array<uint16_t, 16> offsets{};
+    for (int len = 1; len < 15; len++)
+        offsets[len + 1] = static_cast<uint16_t>(offsets[len] + h.counts[len]);
+    h.symbols.assign(static_cast<size_t>(n), 0);
+    for (int i = 0; i < n; i++)
+    {
+        if (lengths[i] != 0)
+            h.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+    }
+    return true;
+}
+
+int DecodeSymbol(BitReader& br, const Huffman& h)
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len < 16; len++)
+    {
+        code |= static_cast<int>(br.Bits(1));
+        const int count = h.counts[len];
+        if (code - count < first)
+            return h.symbols[static_cast<size_t>(index + (code - first))];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+constexpr uint16_t kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+bool InflateCodes(BitReader& br, const Huffman& lengths, const Huffman& distances, std::vector<uint8_t>& out)
+{
+    for (;;)
+    {
+        int symbol = DecodeSymbol(br, lengths);
+        if (symbol < 0 || br.failed)
+            return false;
+        if (symbol < 256)
+        {
+            out.push_back(static_cast<uint8_t>(symbol));
+            continue;
+        }
+        if (symbol == 256)
+            return true;
+
+        symbol -= 257;
+        if (symbol >= 29)
+            return false;
+        const size_t length = kLengthBase[symbol] + br.Bits(kLengthExtra[symbol]);
+        const int distanceSymbol = DecodeSymbol(br, distances);
+        if (distanceSymbol < 0 || distanceSymbol >= 30 || br.failed)
+            return false;
+        const size_t distance = kDistanceBase[distanceSymbol] + br.Bits(kDistanceExtra[distanceSymbol]);
+        if (br.failed || distance > out.size())
+            return false;
+        const size_t from = out.size() - distance;
+        for (size_t i = 0; i < length; i++)
+            out.push_back(out[from + i]);
+    }
+}
+
+bool InflateStored(BitReader& br, std::vector<uint8_t>& out)
+{
+    br.Align();
+    if (br.pos + 4 > br.size)
+        return false;
+    const size_t length = br.data[br.pos] | (br.data[br.pos + 1] << 8);
+    const size_t inverse = br.data[br.pos + 2] | (br.data[br.pos + 3] << 8);
+    br.pos += 4;
+    if (length != (~inverse & 0xffffu) || br.pos + length > br.size)
+        return false;
+    out.insert(out.end(), br.data + br.pos, br.data + br.pos + length);
+    br.pos += length;
+    return true;
+}
+
+bool InflateFixed(BitReader& br, std::vector<uint8_t>& out)
+{
+    uint8_t lengths[288];
+    std::fill(lengths, lengths + 144, 8);
+    std::fill(lengths + 144, lengths + 256, 9);
+    std::fill(lengths + 256, lengths + 280, 7);
+    std::fill(lengths + 280, lengths + 288, 8);
+    uint8_t distanceLengths[30];
+    std::fill(distanceLengths, distanceLengths + 30, 5);
+
+    Huffman lengthCode;
+    Huffman distanceCode;
+    BuildHuffman(lengthCode, lengths, 288);
+    BuildHuffman(distanceCode, distanceLengths, 30);
+    return InflateCodes(br, lengthCode, distanceCode, out);
+}
+
+bool InflateDynamic(BitReader& br, std::vector<uint8_t>& out)
+{
+    static constexpr uint8_t kOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    const int lengthCount = static_cast<int>(br.Bits(5)) + 257;
+    const int distanceCount = static_cast<int>(br.Bits(5)) + 1;
+    const int codeCount = static_cast<int>(br.Bits(4)) + 4;
+    if (lengthCount > 286 || distanceCount > 30)
+        return false;
+
+    uint8_t lengths[320]{};
+    for (int i = 0; i < codeCount; i++)
+        lengths[kOrder[i]] = static_cast<uint8_t>(br.Bits(3));
+    Huffman codeLengths;
+    if (!BuildHuffman(codeLengths, lengths, 19))
+        return false;
+
+    std::fill(lengths, lengths + 320, 0);
+    int index = 0;
+    while (index < lengthCount + distanceCount)
+    {
+        const int symbol = DecodeSymbol(br, codeLengths);
+        if (symbol < 0 || br.failed)
+            return false;
+        if (symbol < 16)
+        {
+            lengths[index++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+
+        uint8_t value = 0;
+        int repeat = 0;
+        if (symbol == 16)
+        {
+            if (index == 0)
+                return false;
+            value = lengths[index - 1];
+            repeat = 3 + static_cast<int>(br.Bits(2));
+        }
+        else if (symbol == 17)
+        {
+            repeat = 3 + static_cast<int>(br.Bits(3));
+        }
+        else
+        {
+            repeat = 11 + static_cast<int>(br.Bits(7));
+        }
+        if (index + repeat > lengthCount + distanceCount)
+            return false;
+        std::fill(lengths + index, lengths + index + repeat, value);
+        index += repeat;
+    }
+    if (lengths[256] == 0)
+        return false;
+
+    Huffman lengthCode;
+    Huffman distanceCode;
+    if (!BuildHuffman(lengthCode, lengths, lengthCount) || !BuildHuffman(distanceCode, lengths + lengthCount, distanceCount))
+        return false;
+    return InflateCodes(br, lengthCode, distanceCode, out);
+}
+
+uint8_t Paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    bool ParseDocument(JsonValue& out)
+    {
+        if (!ParseValue(out, 0))
+            return false;
+        SkipSpace();
+        return pos_ == text_.size();
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    void SkipSpace()
+    {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+            pos_++;
+    }
+
+    bool Consume(char c)
+    {
+        SkipSpace();
+        if (pos_ >= text_.size() || text_[pos_] != c)
+            return false;
+        pos_++;
+        return true;
+    }
+
+    bool ConsumeWord(const char* word)
+    {
+        const size_t length = std::strlen(word);
+        if (text_.compare(pos_, length, word) != 0)
+            return false;
+        pos_ += length;
+        return true;
+    }
+
+    bool ParseString(std::string& out)
+    {
+        if (!Consume('"'))
+            return false;
+        out.clear();
+        while (pos_ < text_.size())
+        {
+            const char c = text_[pos_++];
+            if (c == '"')
+                return true;
+            if (static_cast<unsigned char>(c) < 0x20)
+                return false;
+            if (c != '\\')
+            {
+                out.push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size())
+                return false;
+            const char e = text_[pos_++];
+            switch (e)
+            {
+                case '"':
+                case '\\':
+                case '/':
+                    out.push_back(e);
+                    break;
+                case 'b':
+                    out.push_back('\b');
+                    break;
+                case 'f':
+                    out.push_back('\f');
+                    break;
+                case 'n':
+                    out.push_back('\n');
+                    break;
+                case 'r':
+                    out.push_back('\r');
+                    break;
+                case 't':
+                    out.push_back('\t');
+                    break;
+                case 'u':
+                {
+                    if (pos_ + 4 > text_.size())
+                        return false;
+                    char* end = nullptr;
+                    const std::string hex = text_.substr(pos_, 4);
+                    const unsigned long code = std::strtoul(hex.c_str(), &end, 16);
+                    if (end != hex.c_str() + 4)
+                        return false;
+                    pos_ += 4;
+                    // Basic multilingual plane only; the exporter escapes control characters.
+                    if (code < 0x80)
+                    {
+                        out.push_back(static_cast<char>(code));
+                    }
+                    else if (code < 0x800)
+                    {
+                        out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                    }
+                    else
+                    {
+                        out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+                        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                    }
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool ParseValue(JsonValue& out, int depth)
+    {
+        if (depth > kMaxDepth)
+            return false;
+        SkipSpace();
+        if (pos_ >= text_.size())
+            return false;
+
+        out = {};
+        const char c = text_[pos_];
+        if (c == '{')
+        {
+            pos_++;
+            out.type = JsonValue::Type::Object;
+            if (Consume('}'))
+                return true;
+            do
+            {
+                std::pair<std::string, JsonValue> member;
+                if (!ParseString(member.first) || !Consume(':') || !ParseValue(member.second, depth + 1))
+                    return false;
+                out.object.push_back(std::move(member));
+            } while (Consume(','));
+            return Consume('}');
+        }
+        if (c == '[')
+        {
+            pos_++;
+            out.type = JsonValue::Type::Array;
+            if (Consume(']'))
+                return true;
+            do
+            {
+                out.array.emplace_back();
+                if (!ParseValue(out.array.back(), depth + 1))
+                    return false;
+            } while (Consume(','));
+            return Consume(']');
+        }
+        if (c == '"')
+        {
+            out.type = JsonValue::Type::String;
+            return ParseString(out.string);
+        }
+        if (ConsumeWord("true") || ConsumeWord("false"))
+        {
+            out.type = JsonValue::Type::Bool;
+            out.boolean = text_[pos_ - 1] == 'e' && text_[pos_ - 2] == 'u';
+            return true;
+        }
+        if (ConsumeWord("null"))
+            return true;
+
+        const char* begin = text_.c_str() + pos_;
+        char* end = nullptr;
+        out.number = std::strtod(begin, &end);
+        if (end == begin)
+            return false;
+        out.type = JsonValue::Type::Number;
+        pos_ += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    const std::string& text_;
+    size_t pos_{};
+};
+} // namespace
+
+bool DecodeTgaRgba(const std::vector<uint8_t>& file, int& width, int& height, std::vector<uint8_t>& rgba)
+{
+    if (file.size() < 18 || (file[2] != 2 && file[2] != 10) || file[16] != 32)
+        return false;
+
+    width = file[12] | (file[13] << 8);
+    height = file[14] | (file[15] << 8);
+    const size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+    rgba.assign(pixels * 4, 0);
+
+    size_t pos = 18 + file[0];
+    size_t p = 0;
+    const auto readPixel = [&](size_t dst) {
+        rgba[dst * 4 + 0] = file[pos + 2];
+        rgba[dst * 4 + 1] = file[pos + 1];
+        rgba[dst * 4 + 2] = file[pos + 0];
+        rgba[dst * 4 + 3] = file[pos + 3];
+    };
+    while (p < pixels)
+    {
+        size_t run = 1;
+        bool repeat = false;
+        if (file[2] == 10)
+        {
+            if (pos >= file.size())
+                return false;
+            repeat = (file[pos] & 0x80) != 0;
+            run = (file[pos] & 0x7f) + 1u;
+            pos++;
+        }
+        if (p + run > pixels || pos + (repeat ? 4 : run * 4) > file.size())
+            return false;
+        for (size_t i = 0; i < run; i++, p++)
+        {
+            readPixel(p);
+            if (!repeat)
+                pos += 4;
+        }
+        if (repeat)
+            pos += 4;
+    }
+
+    if ((file[17] & 0x20) == 0)
+    {
+        const size_t stride = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < height / 2; y++)
+            std::swap_ranges(rgba.begin() + static_cast<ptrdiff_t>(static_cast<size_t>(y) * stride), rgba.begin() + static_cast<ptrdiff_t>(static_cast<size_t>(y + 1) * stride),
+                             rgba.begin() + static_cast<ptrdiff_t>(static_cast<size_t>(height - 1 - y) * stride));
+    }
+    return true;
+}
+
+bool ReadTgaRgba(const std::filesystem::path& filePath, int& width, int& height, std::vector<uint8_t>& rgba)
+{
+    std::ifstream in(filePath, std::ios::binary);
+    const std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return DecodeTgaRgba(file, width, height, rgba);
+}
+
+bool InflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    out.clear();
+    if (size < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0)
+        return false;
+
+    BitReader br{data, size, 2};
+    bool last = false;
+    while (!last)
+    {
+        last = br.Bits(1) != 0;
+        const uint32_t type = br.Bits(2);
+        bool ok = false;
+        if (type == 0)
+            ok = InflateStored(br, out);
+        else if (type == 1)
+            ok = InflateFixed(br, out);
+        else if (type == 2)
+            ok = InflateDynamic(br, out);
+        if (!ok || br.failed)
+            return false;
+    }
+
+    br.Align();
+    return br.pos + 4 <= size && ReadU32Be(data + br.pos) == Adler32(out.data(), out.size());
+}
+
+bool DecodePngRgba(const uint8_t* data, size_t size, int& width, int& height, std::vector<uint8_t>& rgba)
+{
+    static constexpr uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (size < 8 || std::memcmp(data, kSignature, 8) != 0)
+        return false;
+
+    std::vector<uint8_t> idat;
+    bool header = false;
+    bool end = false;
+    size_t pos = 8;
+    while (!end)
+    {
+        if (pos + 12 > size)
+            return false;
+        const uint32_t length = ReadU32Be(data + pos);
+        if (length > size - pos - 12)
+            return false;
+        const uint8_t* type = data + pos + 4;
+        const uint8_t* body = data + pos + 8;
+        if (ReadU32Be(body + length) != Crc32(type, length + 4))
+            return false;
+
+        if (std::memcmp(type, "IHDR", 4) == 0)
+        {
+            // 8-bit RGBA, deflate, adaptive filtering, no interlace.
+            if (header || length != 13 || body[8] != 8 || body[9] != 6 || body[10] != 0 || body[11] != 0 || body[12] != 0)
+                return false;
+            width = static_cast<int>(ReadU32Be(body));
+            height = static_cast<int>(ReadU32Be(body + 4));
+            header = width > 0 && height > 0;
+            if (!header)
+                return false;
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0)
+        {
+            idat.insert(idat.end(), body, body + length);
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+        {
+            end = true;
+        }
+        else if ((type[0] & 0x20) == 0)
+        {
+            // Unknown critical chunk.
+            return false;
+        }
+        pos += 12 + length;
+    }
+    if (!header || pos != size)
+        return false;
+
+    std::vector<uint8_t> filtered;
+    const size_t stride = static_cast<size_t>(width) * 4;
+    if (!InflateZlib(idat.data(), idat.size(), filtered) || filtered.size() != (stride + 1) * static_cast<size_t>(height))
+        return false;
+
+    rgba.assign(stride * static_cast<size_t>(height), 0);
+    for (size_t y = 0; y < static_cast<size_t>(height); y++)
+    {
+        const uint8_t filter = filtered[y * (stride + 1)];
+        const uint8_t* src = &filtered[y * (stride + 1) + 1];
+        uint8_t* row = &rgba[y * stride];
+        const uint8_t* up = y > 0 ? row - stride : nullptr;
+        for (size_t i = 0; i < stride; i++)
+        {
+            const int a = i >= 4 ? row[i - 4] : 0;
+            const int b = up ? up[i] : 0;
+            const int c = up && i >= 4 ? up[i - 4] : 0;
+            int predictor = 0;
+            switch (filter)
+            {
+                case 0:
+                    break;
+                case 1:
+                    predictor = a;
+                    break;
+                case 2:
+                    predictor = b;
+                    break;
+                case 3:
+                    predictor = (a + b) / 2;
+                    break;
+                case 4:
+                    predictor = Paeth(a, b, c);
+                    break;
+                default:
+                    return false;
+            }
+            row[i] = static_cast<uint8_t>(src[i] + predictor);
+        }
+    }
+    return true;
+}
+
+bool DecodeQoiRgba(const std::vector<uint8_t>& file, int& width, int& height, std::vector<uint8_t>& rgba)
+{
+    static constexpr uint8_t kEnd[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    if (file.size() < 14 + 8 || std::memcmp(file.data(), "qoif", 4) != 0 || file[12] != 4 || file[13] > 1)
+        return false;
+    width = static_cast<int>(ReadU32Be(&file[4]));
+    height = static_cast<int>(ReadU32Be(&file[8]));
+    if (width <= 0 || height <= 0)
+        return false;
+
+    const size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+    const size_t dataEnd = file.size() - 8;
+    rgba.assign(pixels * 4, 0);
+    std::array<std::array<uint8_t, 4>, 64> index{};
+    std::array<uint8_t, 4> px{0, 0, 0, 255};
+    size_t pos = 14;
+    size_t p = 0;
+    while (p < pixels)
+    {
+        if (pos >= dataEnd)
+            return false;
+        const uint8_t b1 = file[pos++];
+        size_t run = 1;
+        if (b1 == 0xfe || b1 == 0xff)
+        {
+            const size_t channels = b1 == 0xfe ? 3 : 4;
+            if (pos + channels > dataEnd)
+                return false;
+            for (size_t ch = 0; ch < channels; ch++)
+                px[ch] = file[pos++];
+        }
+        else if ((b1 & 0xc0) == 0x00)
+        {
+            px = index[b1];
+        }
+        else if ((b1 & 0xc0) == 0x40)
+        {
+            px[0] = static_cast<uint8_t>(px[0] + ((b1 >> 4) & 3) - 2);
+            px[1] = static_cast<uint8_t>(px[1] + ((b1 >> 2) & 3) - 2);
+            px[2] = static_cast<uint8_t>(px[2] + (b1 & 3) - 2);
+        }
+        else if ((b1 & 0xc0) == 0x80)
+        {
+            if (pos >= dataEnd)
+                return false;
+            const uint8_t b2 = file[pos++];
+            const int dg = (b1 & 0x3f) - 32;
+            px[0] = static_cast<uint8_t>(px[0] + dg - 8 + ((b2 >> 4) & 0x0f));
+            px[1] = static_cast<uint8_t>(px[1] + dg);
+            px[2] = static_cast<uint8_t>(px[2] + dg - 8 + (b2 & 0x0f));
+        }
+        else
+        {
+            run = (b1 & 0x3f) + 1u;
+            if (p + run > pixels)
+                return false;
+        }
+
+        index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64] = px;
+        for (size_t i = 0; i < run; i++, p++)
+            std::copy(px.begin(), px.end(), rgba.begin() + static_cast<ptrdiff_t>(p * 4));
+    }
+    return pos == dataEnd && std::memcmp(&file[dataEnd], kEnd, 8) == 0;
+}
+
+const JsonValue* JsonValue::Find(const std::string& key) const
+{
+    for (const auto& [name, value] : object)
+    {
+        if (name == key)
+            return &value;
+    }
+    return nullptr;
+}
+
+bool ParseJson(const std::string& text, JsonValue& out)
+{
+    JsonParser parser(text);
+    return parser.ParseDocument(out);
+}
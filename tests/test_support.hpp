@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Independent readers for what the exporter writes, so the tests don't check an encoder
+// against itself. Each returns false on anything malformed or unsupported.
+
+// 32-bit type 2 / type 10 TGA as WriteTgaRgba produces it, returned top-down.
+bool DecodeTgaRgba(const std::vector<uint8_t>& file, int& width, int& height, std::vector<uint8_t>& rgba);
+bool ReadTgaRgba(const std::filesystem::path& filePath, int& width, int& height, std::vector<uint8_t>& rgba);
+
+// Full zlib stream: stored, fixed and dynamic Huffman blocks, Adler-32 checked.
+bool InflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+// 8-bit RGBA, non-interlaced PNG; chunk CRCs are checked.
+bool DecodePngRgba(const uint8_t* data, size_t size, int& width, int& height, std::vector<uint8_t>& rgba);
+
+// RGBA (4-channel) QOI, end marker included.
+bool DecodeQoiRgba(const std::vector<uint8_t>& file, int& width, int& height, std::vector<uint8_t>& rgba);
+
+struct JsonValue
+{
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    Type type{Type::Null};
+    bool boolean{};
+    double number{};
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    // Member of an object, or nullptr.
+    const JsonValue* Find(const std::string& key) const;
+};
+
+bool ParseJson(const std::string& text, JsonValue& out);